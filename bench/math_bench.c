@@ -0,0 +1,311 @@
+// Times the mathematics.c kernels over large batches and prints ns/op, optionally as JSON so runs
+// can be compared between commits:
+//   math_bench [--count N] [--repeats N] [--json file]
+// Build with -DCMAKE_BUILD_TYPE=Release, unoptimized numbers say little about the code.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "mathematics.h"
+
+#define BATCH 4096 // inputs cycled through, small enough to stay in cache
+#define DEFAULT_COUNT (1 << 22)
+#define DEFAULT_REPEATS 5
+#define MAX_RESULTS 32
+
+typedef struct
+{
+  const char *name;
+  const char *kernels; // kernel set the call dispatched to, "scalar" for plain C
+  double nsPerOp;      // best of the repeats
+} Result;
+
+static float matricesA[BATCH][16];
+static float matricesB[BATCH][16];
+static float matricesOut[BATCH][16];
+static float vectors[BATCH][3];
+static float packedVectors[BATCH * 3];
+static Camera cameras[BATCH];
+static volatile float sink; // keeps the results alive
+
+static Result results[MAX_RESULTS];
+static int resultCount;
+
+static double now(void)
+{
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+static float randomFloat(float min, float max)
+{
+  return min + (max - min) * (float)rand() / (float)RAND_MAX;
+}
+
+static void fillInputs(void)
+{
+  srand(1);
+  for (int i = 0; i < BATCH; i++)
+  {
+    for (int k = 0; k < 16; k++)
+    {
+      matricesA[i][k] = randomFloat(-1.0f, 1.0f);
+      matricesB[i][k] = randomFloat(-1.0f, 1.0f);
+    }
+    for (int k = 0; k < 3; k++)
+    {
+      vectors[i][k] = randomFloat(-10.0f, 10.0f);
+      packedVectors[i * 3 + k] = vectors[i][k];
+    }
+
+    Camera *camera = &cameras[i];
+    memset(camera, 0, sizeof(*camera));
+    camera->position[2] = randomFloat(1.0f, 100.0f);
+    camera->worldUp[1] = 1.0f;
+    camera->pitch = randomFloat(-89.0f, 89.0f);
+    camera->yaw = randomFloat(-180.0f, 180.0f);
+    updateCameraVectors(camera);
+  }
+}
+
+// each run performs count operations and returns the elapsed seconds
+static double runMultiply(int count)
+{
+  double start = now();
+  for (int n = 0; n < count; n += BATCH)
+  {
+    for (int i = 0; i < BATCH; i++)
+      multiplyMatrices4x4(matricesA[i], matricesB[i], matricesOut[i]);
+  }
+  double elapsed = now() - start;
+  sink = matricesOut[BATCH - 1][15];
+  return elapsed;
+}
+static double runInvert(int count)
+{
+  double start = now();
+  for (int n = 0; n < count; n += BATCH)
+  {
+    for (int i = 0; i < BATCH; i++)
+      invertMatrix4x4(matricesA[i], matricesOut[i]);
+  }
+  double elapsed = now() - start;
+  sink = matricesOut[BATCH - 1][15];
+  return elapsed;
+}
+static double runTranspose(int count)
+{
+  double start = now();
+  for (int n = 0; n < count; n += BATCH)
+  {
+    for (int i = 0; i < BATCH; i++)
+      transposeMatrix4x4(matricesA[i], matricesOut[i]);
+  }
+  double elapsed = now() - start;
+  sink = matricesOut[BATCH - 1][15];
+  return elapsed;
+}
+static double runViewMatrix(int count)
+{
+  double start = now();
+  for (int n = 0; n < count; n += BATCH)
+  {
+    for (int i = 0; i < BATCH; i++)
+      createViewMatrix(matricesOut[i], &cameras[i]);
+  }
+  double elapsed = now() - start;
+  sink = matricesOut[BATCH - 1][14];
+  return elapsed;
+}
+static double runCameraVectors(int count)
+{
+  double start = now();
+  for (int n = 0; n < count; n += BATCH)
+  {
+    for (int i = 0; i < BATCH; i++)
+      updateCameraVectors(&cameras[i]);
+  }
+  double elapsed = now() - start;
+  sink = cameras[BATCH - 1].target[0];
+  return elapsed;
+}
+static double runPerspective(int count)
+{
+  double start = now();
+  for (int n = 0; n < count; n += BATCH)
+  {
+    for (int i = 0; i < BATCH; i++)
+      create_perspective_matrix(0.5f + i * 1e-4f, 1.0f + i * 1e-4f, 0.1f, 300.0f, matricesOut[i]);
+  }
+  double elapsed = now() - start;
+  sink = matricesOut[BATCH - 1][0];
+  return elapsed;
+}
+static double runNormalize(int count)
+{
+  double start = now();
+  for (int n = 0; n < count; n += BATCH)
+  {
+    for (int i = 0; i < BATCH; i++)
+      normalize(vectors[i]);
+  }
+  double elapsed = now() - start;
+  sink = vectors[BATCH - 1][0];
+  return elapsed;
+}
+static double runNormalizeBatched(int count)
+{
+  double start = now();
+  for (int n = 0; n < count; n += BATCH)
+    normalizeVectors(packedVectors, BATCH);
+  double elapsed = now() - start;
+  sink = packedVectors[0];
+  return elapsed;
+}
+
+static void measure(const char *name, const char *kernels, double (*run)(int), int count, int repeats)
+{
+  run(BATCH); // warm caches and the dispatch table
+  double best = 0.0;
+  for (int r = 0; r < repeats; r++)
+  {
+    double elapsed = run(count);
+    if (r == 0 || elapsed < best)
+      best = elapsed;
+  }
+
+  if (resultCount < MAX_RESULTS)
+    results[resultCount++] = (Result){name, kernels, best * 1e9 / count};
+  printf("%-28s %-8s %8.2f ns/op\n", name, kernels, best * 1e9 / count);
+}
+
+// instruction sets the compiler could auto-vectorize the plain C code with
+static const char *buildInstructionSets(void)
+{
+  return ""
+#ifdef __SSE2__
+         " sse2"
+#endif
+#ifdef __AVX__
+         " avx"
+#endif
+#ifdef __AVX2__
+         " avx2"
+#endif
+#ifdef __FMA__
+         " fma"
+#endif
+#ifdef __ARM_NEON
+         " neon"
+#endif
+      ;
+}
+
+static int writeJson(const char *path, int count, int repeats, MathKernels selected, const int supported[3])
+{
+  FILE *file = fopen(path, "w");
+  if (!file)
+  {
+    fprintf(stderr, "Failed to open %s\n", path);
+    return 0;
+  }
+
+  fprintf(file, "{\n  \"benchmark\": \"math\",\n");
+#ifdef __VERSION__
+  fprintf(file, "  \"compiler\": \"%s\",\n", __VERSION__);
+#endif
+#ifdef __OPTIMIZE__
+  fprintf(file, "  \"optimized\": true,\n");
+#else
+  fprintf(file, "  \"optimized\": false,\n");
+#endif
+  const char *instructionSets = buildInstructionSets();
+  if (instructionSets[0] == ' ')
+    instructionSets++;
+  fprintf(file, "  \"build_instruction_sets\": \"%s\",\n", instructionSets);
+  fprintf(file, "  \"selected_kernels\": \"%s\",\n", mathKernelsName(selected));
+  fprintf(file, "  \"supported_kernels\": [");
+  int first = 1;
+  for (int level = MATH_KERNELS_SCALAR; level <= MATH_KERNELS_AVX; level++)
+  {
+    if (!supported[level])
+      continue;
+    fprintf(file, "%s\"%s\"", first ? "" : ", ", mathKernelsName(level));
+    first = 0;
+  }
+  fprintf(file, "],\n  \"count\": %d,\n  \"repeats\": %d,\n  \"results\": [\n", count, repeats);
+  for (int i = 0; i < resultCount; i++)
+  {
+    fprintf(file, "    {\"name\": \"%s\", \"kernels\": \"%s\", \"ns_per_op\": %.3f}%s\n", results[i].name,
+            results[i].kernels, results[i].nsPerOp, i + 1 < resultCount ? "," : "");
+  }
+  fprintf(file, "  ]\n}\n");
+  fclose(file);
+  return 1;
+}
+
+int main(int argc, char **argv)
+{
+  int count = DEFAULT_COUNT;
+  int repeats = DEFAULT_REPEATS;
+  const char *jsonPath = NULL;
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "--count") == 0 && i + 1 < argc)
+      count = atoi(argv[++i]);
+    else if (strcmp(argv[i], "--repeats") == 0 && i + 1 < argc)
+      repeats = atoi(argv[++i]);
+    else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+      jsonPath = argv[++i];
+    else
+    {
+      fprintf(stderr, "usage: %s [--count N] [--repeats N] [--json file]\n", argv[0]);
+      return -1;
+    }
+  }
+  // whole batches only
+  if (count < BATCH)
+    count = BATCH;
+  count -= count % BATCH;
+  if (repeats < 1)
+    repeats = 1;
+
+  MathKernels selected = getMathKernels();
+  int supported[3] = {0};
+  for (int level = MATH_KERNELS_SCALAR; level <= MATH_KERNELS_AVX; level++)
+    supported[level] = setMathKernels(level);
+  setMathKernels(selected);
+
+#ifndef __OPTIMIZE__
+  printf("warning: built without optimization, configure with -DCMAKE_BUILD_TYPE=Release\n");
+#endif
+  printf("build instruction sets:%s\n", buildInstructionSets()[0] ? buildInstructionSets() : " none");
+  printf("selected kernels: %s\n", mathKernelsName(selected));
+  printf("%d operations, best of %d\n\n", count, repeats);
+
+  fillInputs();
+
+  // the dispatched kernels are timed with every set the CPU supports
+  for (int level = MATH_KERNELS_SCALAR; level <= MATH_KERNELS_AVX; level++)
+  {
+    if (!supported[level])
+      continue;
+    setMathKernels(level);
+    measure("multiplyMatrices4x4", mathKernelsName(level), runMultiply, count, repeats);
+    measure("normalizeVectors", mathKernelsName(level), runNormalizeBatched, count, repeats);
+    measure("invertMatrix4x4", mathKernelsName(level), runInvert, count, repeats);
+    measure("transposeMatrix4x4", mathKernelsName(level), runTranspose, count, repeats);
+  }
+  setMathKernels(selected);
+
+  measure("createViewMatrix", "scalar", runViewMatrix, count, repeats);
+  measure("updateCameraVectors", "scalar", runCameraVectors, count, repeats);
+  measure("create_perspective_matrix", "scalar", runPerspective, count, repeats);
+  measure("normalize", "scalar", runNormalize, count, repeats);
+
+  if (jsonPath && !writeJson(jsonPath, count, repeats, selected, supported))
+    return -1;
+  return 0;
+}
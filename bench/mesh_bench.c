@@ -0,0 +1,211 @@
+// Scaling benchmark for sphere generation and upload at stacks = slices = 16 .. 4096:
+//   mesh_bench [--max N] [--json file]
+// Upload needs a GL context, an invisible GLFW window provides it.
+#include <GLFW/glfw3.h>
+#include <glad/glad.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <time.h>
+
+#include "meshes.h"
+
+#define MIN_RESOLUTION 16
+#define DEFAULT_MAX_RESOLUTION 4096
+#define MAX_STEPS 16
+#define TARGET_VERTICES 4000000 // small meshes are repeated until roughly this many vertices were built
+
+typedef struct
+{
+  int resolution; // stacks and slices
+  int vertexCount;
+  int indexCount;
+  int repeats;
+  double generateTime; // seconds, best of the repeats
+  double uploadTime;   // buffer creation and data transfer, finished on the GPU
+  double setupTime;    // setupSphereMesh, generation and upload together
+  size_t meshBytes;    // CPU memory of the generated vertices and indices
+  size_t compactBytes; // GPU memory with VERTEX_LAYOUT_SPHERE and the smallest index type
+  long peakRss;        // KB, process peak after this step
+} Step;
+
+static Step steps[MAX_STEPS];
+static int stepCount;
+
+static double now(void)
+{
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+static long peakRss(void)
+{
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+}
+
+static int measure(int resolution, Step *step)
+{
+  memset(step, 0, sizeof(*step));
+  step->resolution = resolution;
+  long vertices = (long)(resolution + 1) * (resolution + 1);
+  step->repeats = vertices >= TARGET_VERTICES ? 1 : (int)(TARGET_VERTICES / vertices);
+  if (step->repeats > 50)
+    step->repeats = 50;
+
+  for (int r = 0; r < step->repeats; r++)
+  {
+    Vertex *vertexData;
+    unsigned int *indexData;
+    double start = now();
+    generateSphereMesh(1.0f, resolution, resolution, &vertexData, &indexData, &step->vertexCount, &step->indexCount);
+    double generated = now();
+    if (!vertexData)
+      return 0;
+
+    unsigned int vao, vbo, ebo;
+    uploadMesh(vertexData, step->vertexCount, indexData, step->indexCount, &vao, &vbo, &ebo);
+    glFinish();
+    double uploaded = now();
+
+    free(vertexData);
+    free(indexData);
+    glDeleteVertexArrays(1, &vao);
+    glDeleteBuffers(1, &vbo);
+    glDeleteBuffers(1, &ebo);
+
+    if (r == 0 || generated - start < step->generateTime)
+      step->generateTime = generated - start;
+    if (r == 0 || uploaded - generated < step->uploadTime)
+      step->uploadTime = uploaded - generated;
+
+    int indexCount;
+    start = now();
+    setupSphereMesh(1.0f, resolution, resolution, &vao, &vbo, &ebo, &indexCount);
+    glFinish();
+    double setup = now() - start;
+    glDeleteVertexArrays(1, &vao);
+    glDeleteBuffers(1, &vbo);
+    glDeleteBuffers(1, &ebo);
+    if (r == 0 || setup < step->setupTime)
+      step->setupTime = setup;
+  }
+
+  step->meshBytes = step->vertexCount * sizeof(Vertex) + step->indexCount * sizeof(unsigned int);
+  Mesh compact;
+  if (setupSphereMeshLayout(1.0f, resolution, resolution, VERTEX_LAYOUT_SPHERE, &compact))
+  {
+    step->compactBytes = compact.bytes;
+    destroyMesh(&compact);
+  }
+  step->peakRss = peakRss();
+  return 1;
+}
+
+static int writeJson(const char *path)
+{
+  FILE *file = fopen(path, "w");
+  if (!file)
+  {
+    fprintf(stderr, "Failed to open %s\n", path);
+    return 0;
+  }
+
+  fprintf(file, "{\n  \"benchmark\": \"mesh\",\n  \"renderer\": \"%s\",\n", (const char *)glGetString(GL_RENDERER));
+#ifdef __OPTIMIZE__
+  fprintf(file, "  \"optimized\": true,\n");
+#else
+  fprintf(file, "  \"optimized\": false,\n");
+#endif
+  fprintf(file, "  \"vertex_size\": %d,\n  \"results\": [\n", (int)sizeof(Vertex));
+  for (int i = 0; i < stepCount; i++)
+  {
+    Step *step = &steps[i];
+    fprintf(file,
+            "    {\"stacks\": %d, \"slices\": %d, \"vertices\": %d, \"indices\": %d, \"generate_ms\": %.3f, "
+            "\"upload_ms\": %.3f, \"setup_ms\": %.3f, \"mesh_bytes\": %zu, \"bytes_per_vertex\": %.2f, "
+            "\"compact_bytes_per_vertex\": %.2f, "
+            "\"peak_rss_kb\": %ld}%s\n",
+            step->resolution, step->resolution, step->vertexCount, step->indexCount, step->generateTime * 1e3,
+            step->uploadTime * 1e3, step->setupTime * 1e3, step->meshBytes, (double)step->meshBytes / step->vertexCount,
+            (double)step->compactBytes / step->vertexCount, step->peakRss, i + 1 < stepCount ? "," : "");
+  }
+  fprintf(file, "  ]\n}\n");
+  fclose(file);
+  return 1;
+}
+
+int main(int argc, char **argv)
+{
+  int maxResolution = DEFAULT_MAX_RESOLUTION;
+  const char *jsonPath = NULL;
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "--max") == 0 && i + 1 < argc)
+      maxResolution = atoi(argv[++i]);
+    else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+      jsonPath = argv[++i];
+    else
+    {
+      fprintf(stderr, "usage: %s [--max N] [--json file]\n", argv[0]);
+      return -1;
+    }
+  }
+
+  if (!glfwInit())
+  {
+    fprintf(stderr, "Failed to initialize GLFW\n");
+    return -1;
+  }
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+  glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+  glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+  glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+  GLFWwindow *window = glfwCreateWindow(64, 64, "mesh_bench", NULL, NULL);
+  if (!window)
+  {
+    fprintf(stderr, "Failed to create GLFW window\n");
+    glfwTerminate();
+    return -1;
+  }
+  glfwMakeContextCurrent(window);
+  if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+  {
+    fprintf(stderr, "Failed to initialize GLAD\n");
+    glfwTerminate();
+    return -1;
+  }
+
+#ifndef __OPTIMIZE__
+  printf("warning: built without optimization, configure with -DCMAKE_BUILD_TYPE=Release\n");
+#endif
+  printf("renderer: %s\n\n", (const char *)glGetString(GL_RENDERER));
+  printf("%9s %10s %11s %11s %11s %11s %10s %8s %10s %11s\n", "stacks", "vertices", "indices", "generate ms",
+         "upload ms", "setup ms", "mesh MB", "B/vertex", "compact B", "peak RSS MB");
+
+  for (int resolution = MIN_RESOLUTION; resolution <= maxResolution && stepCount < MAX_STEPS; resolution *= 2)
+  {
+    Step *step = &steps[stepCount];
+    if (!measure(resolution, step))
+    {
+      fprintf(stderr, "Out of memory at %d stacks\n", resolution);
+      break;
+    }
+    stepCount++;
+    printf("%9d %10d %11d %11.3f %11.3f %11.3f %10.1f %8.2f %10.2f %11.1f\n", step->resolution, step->vertexCount,
+           step->indexCount, step->generateTime * 1e3, step->uploadTime * 1e3, step->setupTime * 1e3,
+           step->meshBytes / 1048576.0, (double)step->meshBytes / step->vertexCount,
+           (double)step->compactBytes / step->vertexCount, step->peakRss / 1024.0);
+  }
+
+  int result = 0;
+  if (jsonPath && !writeJson(jsonPath))
+    result = -1;
+  glfwDestroyWindow(window);
+  glfwTerminate();
+  return result;
+}
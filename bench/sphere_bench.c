@@ -0,0 +1,148 @@
+// Triangle count against maximum geometric error for the UV sphere, icosphere and cube sphere
+// generators, the error is how far the flat triangles sink below the unit sphere:
+//   sphere_bench [--json file]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "meshes.h"
+
+#define MAX_RESULTS 32
+
+typedef struct
+{
+  const char *scheme;
+  int detail;        // stacks and slices, subdivisions or quads per cube edge
+  int vertexCount;
+  int triangles;     // without the degenerate triangles at the UV sphere's poles
+  double maxError;   // fraction of the radius
+  double generateTime; // seconds
+} Result;
+
+static Result results[MAX_RESULTS];
+static int resultCount;
+
+static double now(void)
+{
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+// closest point of triangle abc to the origin (Ericson, Real-Time Collision Detection 5.1.5)
+static vec3 closestToOrigin(vec3 a, vec3 b, vec3 c)
+{
+  vec3 ab = vec3_sub(b, a), ac = vec3_sub(c, a), ap = vec3_scale(a, -1.0f);
+  float d1 = vec3_dot(ab, ap), d2 = vec3_dot(ac, ap);
+  if (d1 <= 0.0f && d2 <= 0.0f)
+    return a;
+  vec3 bp = vec3_scale(b, -1.0f);
+  float d3 = vec3_dot(ab, bp), d4 = vec3_dot(ac, bp);
+  if (d3 >= 0.0f && d4 <= d3)
+    return b;
+  float vc = d1 * d4 - d3 * d2;
+  if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+    return vec3_add(a, vec3_scale(ab, d1 / (d1 - d3)));
+  vec3 cp = vec3_scale(c, -1.0f);
+  float d5 = vec3_dot(ab, cp), d6 = vec3_dot(ac, cp);
+  if (d6 >= 0.0f && d5 <= d6)
+    return c;
+  float vb = d5 * d2 - d1 * d6;
+  if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+    return vec3_add(a, vec3_scale(ac, d2 / (d2 - d6)));
+  float va = d3 * d6 - d5 * d4;
+  if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f)
+    return vec3_add(b, vec3_scale(vec3_sub(c, b), (d4 - d3) / ((d4 - d3) + (d5 - d6))));
+  float denominator = 1.0f / (va + vb + vc);
+  return vec3_add(a, vec3_add(vec3_scale(ab, vb * denominator), vec3_scale(ac, vc * denominator)));
+}
+
+static void measure(const char *scheme, int detail)
+{
+  if (resultCount == MAX_RESULTS)
+    return;
+
+  Vertex *vertices;
+  unsigned int *indices;
+  int vertexCount, indexCount;
+  double start = now();
+  if (strcmp(scheme, "uv") == 0)
+    generateSphereMesh(1.0f, detail, detail, &vertices, &indices, &vertexCount, &indexCount);
+  else if (strcmp(scheme, "icosphere") == 0)
+    generateIcosphereMesh(1.0f, detail, &vertices, &indices, &vertexCount, &indexCount);
+  else
+    generateCubeSphereMesh(1.0f, detail, &vertices, &indices, &vertexCount, &indexCount);
+  double elapsed = now() - start;
+  if (!vertices)
+    return;
+
+  int triangles = 0;
+  double maxError = 0.0;
+  for (int i = 0; i < indexCount; i += 3)
+  {
+    vec3 a = vec3_load(vertices[indices[i]].position);
+    vec3 b = vec3_load(vertices[indices[i + 1]].position);
+    vec3 c = vec3_load(vertices[indices[i + 2]].position);
+    // the pole rows of the UV sphere repeat one position
+    if (vec3_length(vec3_sub(a, b)) < 1e-6f || vec3_length(vec3_sub(b, c)) < 1e-6f || vec3_length(vec3_sub(c, a)) < 1e-6f)
+      continue;
+    triangles++;
+    double error = 1.0 - vec3_length(closestToOrigin(a, b, c));
+    if (error > maxError)
+      maxError = error;
+  }
+  free(vertices);
+  free(indices);
+
+  results[resultCount++] = (Result){scheme, detail, vertexCount, triangles, maxError, elapsed};
+  printf("%-10s %7d %10d %10d %12.3e %10.3f\n", scheme, detail, vertexCount, triangles, maxError, elapsed * 1e3);
+}
+
+static int writeJson(const char *path)
+{
+  FILE *file = fopen(path, "w");
+  if (!file)
+  {
+    fprintf(stderr, "Failed to open %s\n", path);
+    return 0;
+  }
+  fprintf(file, "{\n  \"benchmark\": \"sphere\",\n  \"results\": [\n");
+  for (int i = 0; i < resultCount; i++)
+  {
+    Result *result = &results[i];
+    fprintf(file, "    {\"scheme\": \"%s\", \"detail\": %d, \"vertices\": %d, \"triangles\": %d, \"max_error\": %.6e, \"generate_ms\": %.3f}%s\n",
+            result->scheme, result->detail, result->vertexCount, result->triangles, result->maxError,
+            result->generateTime * 1e3, i + 1 < resultCount ? "," : "");
+  }
+  fprintf(file, "  ]\n}\n");
+  fclose(file);
+  return 1;
+}
+
+int main(int argc, char **argv)
+{
+  const char *jsonPath = NULL;
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+      jsonPath = argv[++i];
+    else
+    {
+      fprintf(stderr, "usage: %s [--json file]\n", argv[0]);
+      return -1;
+    }
+  }
+
+  printf("%-10s %7s %10s %10s %12s %10s\n", "scheme", "detail", "vertices", "triangles", "max error", "ms");
+  for (int stacks = 8; stacks <= 512; stacks *= 2)
+    measure("uv", stacks);
+  for (int subdivisions = 0; subdivisions <= 7; subdivisions++)
+    measure("icosphere", subdivisions);
+  for (int resolution = 2; resolution <= 256; resolution *= 2)
+    measure("cube", resolution);
+
+  if (jsonPath && !writeJson(jsonPath))
+    return -1;
+  return 0;
+}
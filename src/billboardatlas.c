@@ -0,0 +1,113 @@
+#include "billboardatlas.h"
+
+#include <math.h>
+#include <string.h>
+
+int initBillboardAtlas(BillboardAtlas *atlas)
+{
+  memset(atlas, 0, sizeof(*atlas));
+  for (int i = 0; i < BILLBOARD_TILE_COUNT; i++)
+    atlas->tiles[i].body = -1;
+
+  int size = BILLBOARD_TILE_SIZE * BILLBOARD_ATLAS_TILES;
+  glGenTextures(1, &atlas->texture);
+  glBindTexture(GL_TEXTURE_2D, atlas->texture);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, size, size, 0, GL_RGBA, GL_FLOAT, NULL);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  glGenFramebuffers(1, &atlas->fbo);
+  glBindFramebuffer(GL_FRAMEBUFFER, atlas->fbo);
+  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, atlas->texture, 0);
+  GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  if (status != GL_FRAMEBUFFER_COMPLETE)
+  {
+    fprintf(stderr, "Billboard atlas framebuffer incomplete: 0x%x\n", status);
+    return 0;
+  }
+  return 1;
+}
+
+void destroyBillboardAtlas(BillboardAtlas *atlas)
+{
+  glDeleteFramebuffers(1, &atlas->fbo);
+  glDeleteTextures(1, &atlas->texture);
+  memset(atlas, 0, sizeof(*atlas));
+}
+
+void beginBillboardFrame(BillboardAtlas *atlas)
+{
+  atlas->frame++;
+  atlas->rendered = 0;
+}
+
+static int withinTolerance(const BillboardTile *tile, vec3 viewDirection, vec3 sunDirection, float distance)
+{
+  float viewCos = cosf(to_radians(BILLBOARD_VIEW_TOLERANCE));
+  float sunCos = cosf(to_radians(BILLBOARD_SUN_TOLERANCE));
+  return vec3_dot(tile->viewDirection, viewDirection) >= viewCos && vec3_dot(tile->sunDirection, sunDirection) >= sunCos &&
+         fabsf(distance - tile->distance) <= tile->distance * BILLBOARD_DISTANCE_TOLERANCE;
+}
+
+int acquireBillboardTile(BillboardAtlas *atlas, int body, vec3 viewDirection, vec3 sunDirection, float distance, int *stale)
+{
+  int found = -1, oldest = -1;
+  for (int i = 0; i < BILLBOARD_TILE_COUNT && found < 0; i++)
+  {
+    BillboardTile *tile = &atlas->tiles[i];
+    if (tile->body == body)
+      found = i;
+    else if (tile->body < 0)
+    {
+      if (oldest < 0 || atlas->tiles[oldest].body >= 0)
+        oldest = i;
+    }
+    else if (tile->lastUsed != atlas->frame && (oldest < 0 || (atlas->tiles[oldest].body >= 0 && tile->lastUsed < atlas->tiles[oldest].lastUsed)))
+      oldest = i;
+  }
+
+  *stale = 0;
+  if (found < 0)
+  {
+    // free tiles first, then whatever was drawn longest ago
+    if (oldest < 0)
+      return -1;
+    found = oldest;
+    atlas->tiles[found].body = body;
+    *stale = 1;
+  }
+  BillboardTile *tile = &atlas->tiles[found];
+  tile->lastUsed = atlas->frame;
+  if (*stale || !withinTolerance(tile, viewDirection, sunDirection, distance))
+  {
+    tile->viewDirection = viewDirection;
+    tile->sunDirection = sunDirection;
+    tile->distance = distance;
+    atlas->rendered++;
+    *stale = 1;
+  }
+  return found;
+}
+
+void bindBillboardTile(BillboardAtlas *atlas, int tile)
+{
+  int x = tile % BILLBOARD_ATLAS_TILES * BILLBOARD_TILE_SIZE;
+  int y = tile / BILLBOARD_ATLAS_TILES * BILLBOARD_TILE_SIZE;
+  glBindFramebuffer(GL_FRAMEBUFFER, atlas->fbo);
+  glViewport(x, y, BILLBOARD_TILE_SIZE, BILLBOARD_TILE_SIZE);
+  glEnable(GL_SCISSOR_TEST);
+  glScissor(x, y, BILLBOARD_TILE_SIZE, BILLBOARD_TILE_SIZE);
+  glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+  glClear(GL_COLOR_BUFFER_BIT);
+  glDisable(GL_SCISSOR_TEST);
+}
+
+void billboardTileOffset(int tile, float offset[2])
+{
+  offset[0] = (float)(tile % BILLBOARD_ATLAS_TILES) / BILLBOARD_ATLAS_TILES;
+  offset[1] = (float)(tile / BILLBOARD_ATLAS_TILES) / BILLBOARD_ATLAS_TILES;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <stdio.h>
+
+#include "vecmath.h"
+
+#define BILLBOARD_TILE_SIZE 128
+#define BILLBOARD_ATLAS_TILES 8 // per side, a 1024x1024 atlas
+#define BILLBOARD_TILE_COUNT (BILLBOARD_ATLAS_TILES * BILLBOARD_ATLAS_TILES)
+
+// how far the body's view may drift before its tile is rendered again
+#define BILLBOARD_VIEW_TOLERANCE 1.0f      // degrees between the body-to-camera directions
+#define BILLBOARD_SUN_TOLERANCE 1.0f       // degrees between the sun directions
+#define BILLBOARD_DISTANCE_TOLERANCE 0.05f // relative change of the camera distance
+
+// a cached image of one body, valid for the view it was rendered from
+typedef struct
+{
+  int body; // caller's id of the body, -1 = free
+  vec3 viewDirection; // from the body to the camera
+  vec3 sunDirection;
+  float distance;
+  unsigned int lastUsed; // frame, the least recent tile is recycled first
+} BillboardTile;
+
+// HDR images of distant bodies in fixed size tiles of one texture: radiance premultiplied by the
+// planet's coverage in alpha, composited with glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA)
+typedef struct
+{
+  GLuint texture;
+  GLuint fbo;
+  BillboardTile tiles[BILLBOARD_TILE_COUNT];
+  unsigned int frame;
+  int rendered; // tiles rendered in the current frame
+} BillboardAtlas;
+
+int initBillboardAtlas(BillboardAtlas *atlas);
+void destroyBillboardAtlas(BillboardAtlas *atlas);
+void beginBillboardFrame(BillboardAtlas *atlas);
+
+// tile of the body, taking over the least recently used one when it has none. *stale is set when
+// the tile has to be rendered for this view and sun. -1 when every tile is in use this frame
+int acquireBillboardTile(BillboardAtlas *atlas, int body, vec3 viewDirection, vec3 sunDirection, float distance, int *stale);
+// cleared tile bound as the render target, restore the framebuffer and viewport afterwards
+void bindBillboardTile(BillboardAtlas *atlas, int tile);
+// lower left corner of the tile in texture coordinates, its size is 1 / BILLBOARD_ATLAS_TILES
+void billboardTileOffset(int tile, float offset[2]);
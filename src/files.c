@@ -42,14 +42,21 @@ unsigned int compile_shader(GLenum type, const char *source)
   glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
   if (!success)
   {
-    char *shaderType;
-    if (type == GL_FRAGMENT_SHADER)
+    const char *shaderType;
+    switch (type)
     {
+    case GL_FRAGMENT_SHADER:
       shaderType = "Fragment";
-    }
-    else
-    {
+      break;
+    case GL_TESS_CONTROL_SHADER:
+      shaderType = "Tessellation control";
+      break;
+    case GL_TESS_EVALUATION_SHADER:
+      shaderType = "Tessellation evaluation";
+      break;
+    default:
       shaderType = "Vertex";
+      break;
     }
 
     char infoLog[1024];
@@ -62,49 +69,145 @@ unsigned int compile_shader(GLenum type, const char *source)
   return shader;
 }
 
-// Function to create a shader program
-unsigned int create_shader_program(const char *vertexPath, const char *fragmentPath)
+// Inserts preprocessor defines right after the #version line of a shader
+static char *insert_shader_defines(char *code, const char *defines)
 {
-  char *vertexCode = read_shader_file(vertexPath);
-  char *fragmentCode = read_shader_file(fragmentPath);
+  if (!code || !defines || !defines[0])
+    return code;
+
+  char *versionEnd = strchr(code, '\n');
+  size_t head = versionEnd ? (size_t)(versionEnd - code) + 1 : 0;
+  size_t length = strlen(code);
+  size_t definesLength = strlen(defines);
 
-  if (!vertexCode || !fragmentCode)
+  char *result = malloc(length + definesLength + 2);
+  if (!result)
   {
-    free(vertexCode);
-    free(fragmentCode);
-    return 0;
+    fprintf(stderr, "Unable to allocate memory for shader code\n");
+    return code;
+  }
+  memcpy(result, code, head);
+  memcpy(result + head, defines, definesLength);
+  result[head + definesLength] = '\n';
+  memcpy(result + head + definesLength + 1, code + head, length - head + 1);
+  free(code);
+  return result;
+}
+
+// Replaces #include "file" lines with that file, relative to the including shader. The line
+// may sit inside #ifdef like any other, the included code is compiled out along with it
+static char *resolve_shader_includes(char *code, const char *path)
+{
+  const char *directive = "#include \"";
+  const char *slash = strrchr(path, '/');
+  size_t directoryLength = slash ? (size_t)(slash - path) + 1 : 0;
+  size_t searchFrom = 0;
+
+  while (code)
+  {
+    char *line = strstr(code + searchFrom, directive);
+    if (!line)
+      break;
+    searchFrom = (size_t)(line - code) + 1;
+    if (line != code && line[-1] != '\n')
+      continue;
+    char *name = line + strlen(directive);
+    char *nameEnd = strchr(name, '"');
+    if (!nameEnd)
+      break;
+
+    char includePath[512];
+    snprintf(includePath, sizeof(includePath), "%.*s%.*s", (int)directoryLength, path, (int)(nameEnd - name), name);
+    char *included = read_shader_file(includePath);
+    if (!included)
+    {
+      free(code);
+      return NULL;
+    }
+
+    // included text goes where the line was, its own includes are resolved next
+    char *rest = strchr(nameEnd, '\n');
+    rest = rest ? rest : nameEnd + strlen(nameEnd);
+    size_t head = (size_t)(line - code);
+    size_t includedLength = strlen(included);
+    size_t restLength = strlen(rest);
+    char *result = malloc(head + includedLength + restLength + 1);
+    if (!result)
+    {
+      fprintf(stderr, "Unable to allocate memory for shader code\n");
+      free(included);
+      free(code);
+      return NULL;
+    }
+    memcpy(result, code, head);
+    memcpy(result + head, included, includedLength);
+    memcpy(result + head + includedLength, rest, restLength + 1);
+    free(included);
+    free(code);
+    code = result;
+    searchFrom = head;
   }
+  return code;
+}
 
-  unsigned int vertexShader = compile_shader(GL_VERTEX_SHADER, vertexCode);
-  unsigned int fragmentShader = compile_shader(GL_FRAGMENT_SHADER, fragmentCode);
+// Function to create a shader program
+unsigned int create_shader_program(const char *vertexPath, const char *fragmentPath)
+{
+  return create_shader_program_defines(vertexPath, fragmentPath, NULL);
+}
 
-  free(vertexCode);
-  free(fragmentCode);
+// Same as create_shader_program, defines (e.g. "#define LOG_DEPTH") are added to both stages
+unsigned int create_shader_program_defines(const char *vertexPath, const char *fragmentPath, const char *defines)
+{
+  return create_shader_program_stages(vertexPath, NULL, NULL, fragmentPath, defines);
+}
 
-  if (!vertexShader || !fragmentShader)
+// Links a program from the given stage files, the tessellation paths may be NULL.
+// Defines are added to every stage
+unsigned int create_shader_program_stages(const char *vertexPath, const char *controlPath, const char *evaluationPath, const char *fragmentPath, const char *defines)
+{
+  const GLenum types[4] = {GL_VERTEX_SHADER, GL_TESS_CONTROL_SHADER, GL_TESS_EVALUATION_SHADER, GL_FRAGMENT_SHADER};
+  const char *paths[4] = {vertexPath, controlPath, evaluationPath, fragmentPath};
+  unsigned int shaders[4] = {0};
+  int failed = 0;
+
+  for (int i = 0; i < 4; i++)
   {
-    return 0;
+    if (!paths[i])
+      continue;
+    char *code = insert_shader_defines(resolve_shader_includes(read_shader_file(paths[i]), paths[i]), defines);
+    if (code)
+      shaders[i] = compile_shader(types[i], code);
+    free(code);
+    if (!shaders[i])
+      failed = 1;
   }
 
-  unsigned int program = glCreateProgram();
-  glAttachShader(program, vertexShader);
-  glAttachShader(program, fragmentShader);
-  glLinkProgram(program);
-  // Check for linking errors
-  GLint success;
-  glGetProgramiv(program, GL_LINK_STATUS, &success);
-  if (!success)
+  unsigned int program = 0;
+  if (!failed)
   {
-    char infoLog[512];
-    glGetProgramInfoLog(program, 512, NULL, infoLog);
-    fprintf(stderr, "Shader program linking error: %s\n", infoLog);
-    glDeleteProgram(program);
-    return 0;
+    program = glCreateProgram();
+    for (int i = 0; i < 4; i++)
+      if (shaders[i])
+        glAttachShader(program, shaders[i]);
+    glLinkProgram(program);
+    // Check for linking errors
+    GLint success;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success)
+    {
+      char infoLog[512];
+      glGetProgramInfoLog(program, 512, NULL, infoLog);
+      fprintf(stderr, "Shader program linking error: %s\n", infoLog);
+      glDeleteProgram(program);
+      program = 0;
+    }
   }
 
   // Clean up shaders as they are no longer needed
-  glDeleteShader(vertexShader);
-  glDeleteShader(fragmentShader);
+  for (int i = 0; i < 4; i++)
+    if (shaders[i])
+      glDeleteShader(shaders[i]);
   return program;
 }
 GLuint loadPNGTexture(const char *filename)
@@ -1,6 +1,7 @@
 #include <glad/glad.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <libpng16/png.h>
 
 // shaders
@@ -9,6 +10,9 @@
 void createShader(unsigned int *shaderProg, const char *vertexPath, const char *fragmentPath);
 // use this function to create shaders
 unsigned int create_shader_program(const char *vertexPath, const char *fragmentPath);
+unsigned int create_shader_program_defines(const char *vertexPath, const char *fragmentPath, const char *defines);
+// tessellation stages may be NULL
+unsigned int create_shader_program_stages(const char *vertexPath, const char *controlPath, const char *evaluationPath, const char *fragmentPath, const char *defines);
 
 // images
 GLuint loadPNGTexture(const char *filename);
@@ -0,0 +1,213 @@
+#include "geometryarena.h"
+
+#include <string.h>
+
+static size_t alignIndexOffset(size_t offset)
+{
+  return (offset + ARENA_INDEX_ALIGNMENT - 1) & ~(size_t)(ARENA_INDEX_ALIGNMENT - 1);
+}
+
+static void createArenaBuffers(GeometryArena *arena, unsigned int *vbo, unsigned int *ebo)
+{
+  glGenBuffers(1, vbo);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, *vbo);
+  glBufferData(GL_COPY_WRITE_BUFFER, (size_t)arena->vertexCapacity * arena->stride, NULL, GL_STATIC_DRAW);
+  glGenBuffers(1, ebo);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, *ebo);
+  glBufferData(GL_COPY_WRITE_BUFFER, arena->indexCapacity, NULL, GL_STATIC_DRAW);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+// the VAO keeps its name so meshes only need new offsets when the buffers are replaced
+static void attachArenaBuffers(GeometryArena *arena)
+{
+  glBindVertexArray(arena->vao);
+  glBindBuffer(GL_ARRAY_BUFFER, arena->vbo);
+  setupVertexAttributes(arena->layout);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, arena->ebo);
+  glBindVertexArray(0);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+int initGeometryArena(GeometryArena *arena, VertexLayout layout, int vertexCapacity, size_t indexCapacity)
+{
+  memset(arena, 0, sizeof(*arena));
+  arena->layout = layout;
+  arena->stride = vertexLayoutSize(layout);
+  arena->vertexCapacity = vertexCapacity;
+  arena->indexCapacity = alignIndexOffset(indexCapacity);
+
+  glGenVertexArrays(1, &arena->vao);
+  createArenaBuffers(arena, &arena->vbo, &arena->ebo);
+  attachArenaBuffers(arena);
+  return 1;
+}
+
+void destroyGeometryArena(GeometryArena *arena)
+{
+  glDeleteVertexArrays(1, &arena->vao);
+  glDeleteBuffers(1, &arena->vbo);
+  glDeleteBuffers(1, &arena->ebo);
+  memset(arena, 0, sizeof(*arena));
+}
+
+// copies the live ranges back to back into new buffers of the current capacity
+static void rebuildArena(GeometryArena *arena)
+{
+  unsigned int vbo, ebo;
+  createArenaBuffers(arena, &vbo, &ebo);
+
+  int vertexTop = 0;
+  size_t indexTop = 0;
+  for (int i = 0; i < ARENA_MAX_MESHES; i++)
+  {
+    ArenaRange *range = &arena->ranges[i];
+    if (!range->used)
+      continue;
+    glBindBuffer(GL_COPY_READ_BUFFER, arena->vbo);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, vbo);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, (size_t)range->firstVertex * arena->stride,
+                        (size_t)vertexTop * arena->stride, (size_t)range->vertexCount * arena->stride);
+    glBindBuffer(GL_COPY_READ_BUFFER, arena->ebo);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, ebo);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, range->indexOffset, indexTop, range->indexBytes);
+
+    range->firstVertex = vertexTop;
+    range->indexOffset = indexTop;
+    vertexTop += range->vertexCount;
+    indexTop = alignIndexOffset(indexTop + range->indexBytes);
+  }
+  glBindBuffer(GL_COPY_READ_BUFFER, 0);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+  glDeleteBuffers(1, &arena->vbo);
+  glDeleteBuffers(1, &arena->ebo);
+  arena->vbo = vbo;
+  arena->ebo = ebo;
+  arena->vertexTop = vertexTop;
+  arena->indexTop = indexTop;
+  arena->holeVertices = 0;
+  arena->holeIndexBytes = 0;
+  arena->compactions++;
+  attachArenaBuffers(arena);
+}
+
+int compactGeometryArena(GeometryArena *arena)
+{
+  if (!arena->holeVertices && !arena->holeIndexBytes)
+    return 0;
+  rebuildArena(arena);
+  return 1;
+}
+
+int arenaNeedsCompaction(const GeometryArena *arena)
+{
+  return arena->holeVertices * 2 > arena->vertexTop || arena->holeIndexBytes * 2 > arena->indexTop;
+}
+
+void arenaMeshOffsets(const GeometryArena *arena, int id, Mesh *mesh)
+{
+  mesh->baseVertex = arena->ranges[id].firstVertex;
+  mesh->indexOffset = arena->ranges[id].indexOffset;
+}
+
+int arenaAddMesh(GeometryArena *arena, const Vertex *vertices, int vertexCount, const unsigned int *indices, int indexCount, GLenum primitive, Mesh *mesh)
+{
+  int id = -1;
+  for (int i = 0; i < ARENA_MAX_MESHES && id < 0; i++)
+    if (!arena->ranges[i].used)
+      id = i;
+  if (id < 0)
+  {
+    fprintf(stderr, "Geometry arena is full (%d meshes)\n", ARENA_MAX_MESHES);
+    return -1;
+  }
+
+  // indices are relative to the base vertex, so the mesh's own size picks the index type
+  void *packedVertices;
+  const void *vertexData = packVertices(vertices, vertexCount, arena->layout, &packedVertices);
+  int shortIndices = vertexCount <= MESH_MAX_SHORT_VERTICES;
+  size_t indexBytes = (size_t)indexCount * (shortIndices ? sizeof(uint16_t) : sizeof(unsigned int));
+  uint16_t *packedIndices = shortIndices ? packShortIndices(indices, indexCount) : NULL;
+  if (!vertexData || (shortIndices && !packedIndices))
+  {
+    fprintf(stderr, "Failed to allocate a packed mesh of %d vertices\n", vertexCount);
+    free(packedVertices);
+    free(packedIndices);
+    return -1;
+  }
+
+  // out of space at the top: squeeze out the holes, doubling the buffers when that is not enough
+  if (arena->vertexTop + vertexCount > arena->vertexCapacity || arena->indexTop + indexBytes > arena->indexCapacity)
+  {
+    int liveVertices = arena->vertexTop - arena->holeVertices;
+    size_t liveIndexBytes = arena->indexTop - arena->holeIndexBytes;
+    while (liveVertices + vertexCount > arena->vertexCapacity)
+      arena->vertexCapacity *= 2;
+    // each live range may need padding up to the alignment after compaction
+    while (liveIndexBytes + ARENA_MAX_MESHES * ARENA_INDEX_ALIGNMENT + indexBytes > arena->indexCapacity)
+      arena->indexCapacity *= 2;
+    rebuildArena(arena);
+  }
+
+  ArenaRange *range = &arena->ranges[id];
+  range->used = 1;
+  range->firstVertex = arena->vertexTop;
+  range->vertexCount = vertexCount;
+  range->indexOffset = arena->indexTop;
+  range->indexBytes = indexBytes;
+  arena->vertexTop += vertexCount;
+  arena->indexTop = alignIndexOffset(arena->indexTop + indexBytes);
+
+  glBindBuffer(GL_COPY_WRITE_BUFFER, arena->vbo);
+  glBufferSubData(GL_COPY_WRITE_BUFFER, (size_t)range->firstVertex * arena->stride, (size_t)vertexCount * arena->stride, vertexData);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, arena->ebo);
+  glBufferSubData(GL_COPY_WRITE_BUFFER, range->indexOffset, indexBytes, shortIndices ? (const void *)packedIndices : indices);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+  free(packedVertices);
+  free(packedIndices);
+
+  // the buffers belong to the arena, the mesh only borrows its VAO
+  memset(mesh, 0, sizeof(*mesh));
+  mesh->vao = arena->vao;
+  mesh->indexCount = indexCount;
+  mesh->indexType = shortIndices ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+  mesh->primitive = primitive;
+  mesh->layout = arena->layout;
+  mesh->bytes = (size_t)vertexCount * arena->stride + indexBytes;
+  arenaMeshOffsets(arena, id, mesh);
+  return id;
+}
+
+// the tops sit at the end of the highest live range, so freeing the top mesh also gives back any holes
+// directly below it. Index ranges start aligned, so each live one covers its byte count rounded up
+static void updateArenaUsage(GeometryArena *arena)
+{
+  int vertexTop = 0, liveVertices = 0;
+  size_t indexTop = 0, liveIndexBytes = 0;
+  for (int i = 0; i < ARENA_MAX_MESHES; i++)
+  {
+    const ArenaRange *range = &arena->ranges[i];
+    if (!range->used)
+      continue;
+    if (range->firstVertex + range->vertexCount > vertexTop)
+      vertexTop = range->firstVertex + range->vertexCount;
+    if (alignIndexOffset(range->indexOffset + range->indexBytes) > indexTop)
+      indexTop = alignIndexOffset(range->indexOffset + range->indexBytes);
+    liveVertices += range->vertexCount;
+    liveIndexBytes += alignIndexOffset(range->indexBytes);
+  }
+  arena->vertexTop = vertexTop;
+  arena->indexTop = indexTop;
+  arena->holeVertices = vertexTop - liveVertices;
+  arena->holeIndexBytes = indexTop - liveIndexBytes;
+}
+
+void arenaRemoveMesh(GeometryArena *arena, int id)
+{
+  ArenaRange *range = &arena->ranges[id];
+  if (!range->used)
+    return;
+  range->used = 0;
+  updateArenaUsage(arena);
+}
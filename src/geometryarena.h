@@ -0,0 +1,48 @@
+#pragma once
+
+#include "meshes.h"
+
+#define ARENA_MAX_MESHES 64
+#define ARENA_INITIAL_VERTICES 65536
+#define ARENA_INITIAL_INDEX_BYTES (1 << 20)
+#define ARENA_INDEX_ALIGNMENT 4 // ranges start on a multiple of the largest index size
+
+// where one mesh lives inside the arena buffers
+typedef struct
+{
+  int used;
+  int firstVertex;
+  int vertexCount;
+  size_t indexOffset; // bytes
+  size_t indexBytes;
+} ArenaRange;
+
+// one vertex and one index buffer shared by every static mesh of a layout, drawn from a single
+// VAO with glDrawElementsBaseVertex. Meshes are appended at the top, removing one leaves a hole
+// until compactGeometryArena moves the live ranges together
+typedef struct
+{
+  VertexLayout layout;
+  int stride;
+  unsigned int vao, vbo, ebo;
+  int vertexCapacity, vertexTop;
+  size_t indexCapacity, indexTop;
+  int holeVertices; // space below the tops that belongs to removed meshes
+  size_t holeIndexBytes;
+  ArenaRange ranges[ARENA_MAX_MESHES];
+  int compactions;
+} GeometryArena;
+
+int initGeometryArena(GeometryArena *arena, VertexLayout layout, int vertexCapacity, size_t indexCapacity);
+void destroyGeometryArena(GeometryArena *arena);
+
+// packs and copies the mesh into the arena, growing it if needed. Returns the range id and fills
+// in mesh for drawMesh with the arena VAO bound (or renderMesh), -1 on failure
+int arenaAddMesh(GeometryArena *arena, const Vertex *vertices, int vertexCount, const unsigned int *indices, int indexCount, GLenum primitive, Mesh *mesh);
+void arenaRemoveMesh(GeometryArena *arena, int id);
+// true when removed meshes waste more than half of the used space
+int arenaNeedsCompaction(const GeometryArena *arena);
+// moves the live ranges to the start of fresh buffers, offsets change so refresh meshes with
+// arenaMeshOffsets afterwards
+int compactGeometryArena(GeometryArena *arena);
+void arenaMeshOffsets(const GeometryArena *arena, int id, Mesh *mesh);
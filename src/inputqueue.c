@@ -0,0 +1,42 @@
+#include "inputqueue.h"
+
+void initInputQueue(InputQueue *queue)
+{
+  atomic_init(&queue->head, 0);
+  atomic_init(&queue->tail, 0);
+  atomic_init(&queue->dropped, 0);
+}
+
+int pushInputEvent(InputQueue *queue, const InputEvent *event)
+{
+  unsigned int head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+  unsigned int tail = atomic_load_explicit(&queue->tail, memory_order_acquire);
+  if (head - tail == INPUT_QUEUE_SIZE)
+  {
+    atomic_fetch_add_explicit(&queue->dropped, 1, memory_order_relaxed);
+    return 0;
+  }
+
+  queue->events[head & (INPUT_QUEUE_SIZE - 1)] = *event;
+  // publish the slot after it has been written
+  atomic_store_explicit(&queue->head, head + 1, memory_order_release);
+  return 1;
+}
+
+int popInputEvent(InputQueue *queue, InputEvent *event)
+{
+  unsigned int tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+  unsigned int head = atomic_load_explicit(&queue->head, memory_order_acquire);
+  if (head == tail)
+    return 0;
+
+  *event = queue->events[tail & (INPUT_QUEUE_SIZE - 1)];
+  // hand the slot back to the producer after it has been read
+  atomic_store_explicit(&queue->tail, tail + 1, memory_order_release);
+  return 1;
+}
+
+int inputQueueEmpty(InputQueue *queue)
+{
+  return atomic_load(&queue->head) == atomic_load(&queue->tail);
+}
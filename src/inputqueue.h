@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stdatomic.h>
+
+#define INPUT_QUEUE_SIZE 1024 // must be a power of two
+
+typedef enum
+{
+  INPUT_KEY,
+  INPUT_CURSOR,
+  INPUT_RESIZE,
+  INPUT_REFRESH
+} InputEventType;
+
+typedef struct
+{
+  InputEventType type;
+  int key, action;   // INPUT_KEY
+  double x, y;       // INPUT_CURSOR
+  int width, height; // INPUT_RESIZE
+  double time;       // glfwGetTime() when the event arrived
+} InputEvent;
+
+// single producer / single consumer ring, the event thread pushes and the render thread pops
+typedef struct
+{
+  InputEvent events[INPUT_QUEUE_SIZE];
+  _Alignas(64) atomic_uint head; // next slot written by the producer
+  _Alignas(64) atomic_uint tail; // next slot read by the consumer
+  atomic_uint dropped;           // events lost because the consumer fell behind
+} InputQueue;
+
+void initInputQueue(InputQueue *queue);
+int pushInputEvent(InputQueue *queue, const InputEvent *event); // returns 0 when the queue is full
+int popInputEvent(InputQueue *queue, InputEvent *event);        // returns 0 when the queue is empty
+int inputQueueEmpty(InputQueue *queue);
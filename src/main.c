@@ -1,15 +1,25 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
+#include <pthread.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
 
-#include "files.h"
+#include "inputqueue.h"
 #include "mathematics.h"
-#include "meshes.h"
+#include "renderer.h"
 
 void framebuffer_size_callback(GLFWwindow *window, int width, int height);
-void processInput(GLFWwindow *window);
 void mouse_callback(GLFWwindow *window, double xpos, double ypos);
+void window_refresh_callback(GLFWwindow *window);
+void key_callback(GLFWwindow *window, int key, int scancode, int action, int mods);
+void *renderLoop(void *arg);
+void handleInputEvent(const InputEvent *event);
+int processInput(void);
+void mouseMoved(double xpos, double ypos);
+int benchmarkFrame(void);
 // Base Rayleigh coefficient for a reference radius (e.g., 1.0 unit radius)
 const float BASE_RAYLEIGH_COEFFICIENT[3] = {0.0025f, 0.0058f, 0.014f};
 const float REFERENCE_RADIUS = 686.0f; // Reference radius for base Rayleigh coefficient
@@ -26,6 +36,8 @@ void calculateRayleighCoefficient(float planetRadius, float result[3])
 #define MOUSE_SENSITIVITY 0.1f
 #define CAMERA_SPEED 0.05f
 #define PLANET_SCALE 16.0f
+#define SUN_SPEED 0.2f             // radians per second
+#define SUN_REDRAW_THRESHOLD 1.0f  // degrees the sun may move before an idle frame is redrawn
 
 int Width = 1200;
 int Height = 1000;
@@ -45,6 +57,83 @@ float lastY = 400;
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 
+// on-demand redraw
+typedef struct
+{
+  int onDemand;       // only redraw when something changed
+  int dirty;          // camera, window or parameters changed since the last presented frame
+  int moving;         // input is still held, keep polling instead of sleeping
+  int resized;        // projection matrix needs to be rebuilt
+  float lastSunAngle; // sun angle of the last presented frame
+  float settleUntil;  // keep drawing until exposure has adapted to the last change
+} RedrawState;
+RendererSettings settings = {.depthMode = DEPTH_STANDARD, .antialiasing = AA_MSAA, .framesInFlight = DEFAULT_FRAMES_IN_FLIGHT, .reportLatency = 0, .vertexLayout = VERTEX_LAYOUT_FULL, .sphereDetail = SPHERE_DETAIL, .proceduralSpheres = 0, .optimizeIndices = 1, .triangleStrips = 0, .tessellation = 0, .impostorSpheres = 0, .billboards = 0};
+RedrawState redraw = {.onDemand = 0, .dirty = 1, .moving = 0, .resized = 1, .lastSunAngle = 0.0f, .settleUntil = 0.0f};
+
+// renders a fixed number of frames with every antialiasing mode and prints their cost
+#define BENCHMARK_WARMUP_FRAMES 30
+typedef struct
+{
+  int frames; // measured frames per mode, 0 = no benchmark
+  int mode;
+  int frame;
+  double start;
+  double gpuTime[AA_MODE_COUNT];
+  double frameTime[AA_MODE_COUNT];
+} Benchmark;
+Benchmark benchmark = {.frames = 0};
+
+Renderer renderer;
+int drawWireframe = 0;
+int keyDown[GLFW_KEY_LAST + 1]; // key state as seen by the render thread
+
+// the main thread pumps GLFW events, the render thread owns the GL context
+typedef struct
+{
+  pthread_t thread;
+  InputQueue input;
+  pthread_mutex_t lock; // orders a push against the render thread's empty check before it sleeps
+  pthread_cond_t wake;
+  atomic_int quit;
+} RenderThread;
+RenderThread renderThread = {.lock = PTHREAD_MUTEX_INITIALIZER, .wake = PTHREAD_COND_INITIALIZER};
+
+// always under the lock: a signal sent between the render thread's empty check and its wait would
+// be lost, and events are rare enough for the lock to cost nothing
+void wakeRenderThread(void)
+{
+  pthread_mutex_lock(&renderThread.lock);
+  pthread_cond_signal(&renderThread.wake);
+  pthread_mutex_unlock(&renderThread.lock);
+}
+
+void sendInputEvent(InputEvent event)
+{
+  event.time = glfwGetTime();
+  pushInputEvent(&renderThread.input, &event);
+  wakeRenderThread();
+}
+
+// sleeps until input arrives, the timeout (seconds) expires or the application quits
+void waitForInput(double timeout)
+{
+  struct timespec deadline;
+  clock_gettime(CLOCK_REALTIME, &deadline);
+  deadline.tv_sec += (time_t)timeout;
+  deadline.tv_nsec += (long)((timeout - (double)(time_t)timeout) * 1e9);
+  if (deadline.tv_nsec >= 1000000000L)
+  {
+    deadline.tv_sec++;
+    deadline.tv_nsec -= 1000000000L;
+  }
+
+  pthread_mutex_lock(&renderThread.lock);
+  // a push either happened before this check or signals after the wait has started
+  if (inputQueueEmpty(&renderThread.input) && !atomic_load(&renderThread.quit))
+    pthread_cond_timedwait(&renderThread.wake, &renderThread.lock, &deadline);
+  pthread_mutex_unlock(&renderThread.lock);
+}
+
 void setSunAngle(float sunVar[3], double angle)
 {
   sunVar[1] = sin(angle);
@@ -52,14 +141,61 @@ void setSunAngle(float sunVar[3], double angle)
   return;
 }
 
-int main()
+int main(int argc, char **argv)
 {
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "--on-demand") == 0)
+      redraw.onDemand = 1;
+    else if (strcmp(argv[i], "--reversed-z") == 0)
+      settings.depthMode = DEPTH_REVERSED_Z;
+    else if (strcmp(argv[i], "--log-depth") == 0)
+      settings.depthMode = DEPTH_LOGARITHMIC;
+    else if (strcmp(argv[i], "--frames-in-flight") == 0 && i + 1 < argc)
+      settings.framesInFlight = atoi(argv[++i]);
+    else if (strcmp(argv[i], "--latency") == 0)
+      settings.reportLatency = 1;
+    else if (strcmp(argv[i], "--aa") == 0 && i + 1 < argc)
+    {
+      i++;
+      for (int mode = 0; mode < AA_MODE_COUNT; mode++)
+      {
+        if (strcmp(argv[i], antialiasingName(mode)) == 0)
+          settings.antialiasing = mode;
+      }
+    }
+    else if (strcmp(argv[i], "--unoptimized-indices") == 0)
+      settings.optimizeIndices = 0;
+    else if (strcmp(argv[i], "--strips") == 0)
+      settings.triangleStrips = 1;
+    else if (strcmp(argv[i], "--procedural") == 0)
+      settings.proceduralSpheres = 1;
+    else if (strcmp(argv[i], "--tessellation") == 0)
+      settings.tessellation = 1;
+    else if (strcmp(argv[i], "--impostors") == 0)
+      settings.impostorSpheres = 1;
+    else if (strcmp(argv[i], "--billboards") == 0)
+      settings.billboards = 1;
+    else if (strcmp(argv[i], "--detail") == 0 && i + 1 < argc)
+      settings.sphereDetail = atoi(argv[++i]);
+    else if (strcmp(argv[i], "--vertices") == 0 && i + 1 < argc)
+    {
+      i++;
+      for (int layout = 0; layout < VERTEX_LAYOUT_COUNT; layout++)
+      {
+        if (strcmp(argv[i], vertexLayoutName(layout)) == 0)
+          settings.vertexLayout = layout;
+      }
+    }
+    else if (strcmp(argv[i], "--benchmark") == 0 && i + 1 < argc)
+      benchmark.frames = atoi(argv[++i]);
+  }
+
   glfwInit();
 
   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
   glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-  glfwWindowHint(GLFW_SAMPLES, 4);
 #ifdef __APPLE__
   glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 #endif
@@ -83,22 +219,62 @@ int main()
   // GLFW Callbacks
   glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
   glfwSetCursorPosCallback(window, mouse_callback);
+  glfwSetWindowRefreshCallback(window, window_refresh_callback);
   glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-  // GL Config
-  glEnable(GL_DEPTH_TEST);
-  glEnable(GL_MULTISAMPLE);
-  // shaders
-  unsigned int basicShader, atmosphereShader;
-  basicShader = create_shader_program("../src/shaders/basic.vs", "../src/shaders/phong.fs");
-  atmosphereShader = create_shader_program("../src/shaders/copy.vs", "../src/shaders/copy.fs");
+  glfwSetKeyCallback(window, key_callback);
+  glfwGetFramebufferSize(window, &Width, &Height);
+
+  // shaders, meshes and render passes
+  if (!initRenderer(&renderer, &settings, PLANET_SCALE, PLANET_SCALE * 1.1f, Width, Height))
+  {
+    printf("Renderer Failed to Init! Terminating\n");
+    glfwTerminate();
+    return -3;
+  }
+
+  // hand the context over to the render thread
+  glfwMakeContextCurrent(NULL);
+  initInputQueue(&renderThread.input);
+  if (pthread_create(&renderThread.thread, NULL, renderLoop, window) != 0)
+  {
+    printf("Render Thread Failed to Start! Terminating\n");
+    glfwTerminate();
+    return -4;
+  }
+
+  // this thread never waits on the GPU, it only turns window events into input events
+  while (!glfwWindowShouldClose(window))
+    glfwWaitEvents();
+
+  atomic_store(&renderThread.quit, 1);
+  wakeRenderThread();
+  pthread_join(renderThread.thread, NULL);
+  if (atomic_load(&renderThread.input.dropped))
+    printf("%u input events were dropped\n", atomic_load(&renderThread.input.dropped));
+
+  glfwDestroyWindow(window);
+  glfwTerminate();
+  return 0;
+}
+
+void *renderLoop(void *arg)
+{
+  GLFWwindow *window = arg;
+  glfwMakeContextCurrent(window);
+  if (benchmark.frames > 0)
+  {
+    // measure the GPU, not the display refresh
+    glfwSwapInterval(0);
+    redraw.onDemand = 0;
+    setAntialiasing(&renderer, 0);
+  }
 
   // variables
   float lightPos[3] = {0.0f, PLANET_SCALE * 4.0f, 0.0f};
 
   float lightDirection[3] = {0.5f, -1.0f, 0.0f};
   normalize(lightDirection);
-  float planetRadius = PLANET_SCALE;
-  float atmosphereRadius = planetRadius * 1.1;
+  float atmosphereRadius = renderer.atmosphereRadius;
   // float rayleighCoefficient[3] = {0.58, 1.35, 3.31};
   float rayleighCoefficient[3];
   calculateRayleighCoefficient(PLANET_SCALE, rayleighCoefficient);
@@ -107,190 +283,193 @@ int main()
   float mieColorFactor[3] = {0.8, 0.6, 0.3};
   float mieDirectionality = 0.8;
 
-  // meshes
-  unsigned int vao,
-      vbo, ebo;
-  int indexCount;
-  setupSphereMesh(PLANET_SCALE, 45, 45, &vao, &vbo, &ebo, &indexCount);
-  unsigned int avao, avbo, aebo;
-  int aindexCount;
-  setupSphereMesh(atmosphereRadius, 45, 45, &avao, &avbo, &aebo, &aindexCount);
-
-  int drawWireframe = 0;
-  while (!glfwWindowShouldClose(window))
+  FrameParams frame = {.wireframe = 0};
+  double pendingInputTime = -1.0; // oldest input not yet in a submitted frame
+  while (!atomic_load(&renderThread.quit))
   {
-    if (glfwGetKey(window, GLFW_KEY_TAB) == GLFW_PRESS)
-      drawWireframe = !drawWireframe;
-
-    if (drawWireframe)
+    // sleep until an event arrives or the sun has moved far enough to be visible
+    int adapting = (float)glfwGetTime() < redraw.settleUntil;
+    if (redraw.onDemand && !redraw.dirty && !redraw.moving && !adapting)
     {
-      glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+      float sunLeft = RADIANS(SUN_REDRAW_THRESHOLD) - fabsf((float)glfwGetTime() * SUN_SPEED - redraw.lastSunAngle);
+      waitForInput(sunLeft > 0.0f ? sunLeft / SUN_SPEED : 0.0);
     }
-    else
+
+    // block while too many frames are queued, input is read as late as possible afterwards
+    beginFrame(&renderer);
+
+    // apply everything the event thread queued since the last frame
+    InputEvent event;
+    while (popInputEvent(&renderThread.input, &event))
     {
-      glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+      handleInputEvent(&event);
+      if (pendingInputTime < 0.0)
+        pendingInputTime = event.time;
     }
-    glfwPollEvents();
-    processInput(window);
+    redraw.moving = processInput();
+    if (redraw.moving)
+      redraw.dirty = 1;
 
-    // rendering
-    glClearColor(0.0f, 01.0f, 0.0f, 1.0f);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    float sunAngle = (float)glfwGetTime() * SUN_SPEED;
+    if (redraw.onDemand && !redraw.dirty && !adapting && fabsf(sunAngle - redraw.lastSunAngle) < RADIANS(SUN_REDRAW_THRESHOLD))
+      continue; // nothing changed, the front buffer still holds the last frame
+
+    float currentFrame = (float)glfwGetTime();
+    deltaTime = currentFrame - lastFrame;
+    lastFrame = currentFrame;
+    if (redraw.dirty)
+      redraw.settleUntil = currentFrame + EXPOSURE_SETTLE_TIME;
 
     // Uniforms and Matrices
-    float projectionMatrix[16];
-    create_perspective_matrix(radians(45.0f), (float)Width / (float)Height, 0.1f, 300.0f, projectionMatrix);
+    if (redraw.resized)
+    {
+      createProjectionMatrix(&renderer, (float)Width / (float)Height, frame.projection);
+      resizeRenderer(&renderer, Width, Height);
+      redraw.resized = 0;
+    }
 
-    float viewMatrix[16];
     updateCameraVectors(&camera);
-    createViewMatrix(viewMatrix, &camera);
-
-    float modelMatrix[16];
-    create_identity_matrix(modelMatrix);
-
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    createViewMatrix(frame.view, &camera);
+    create_identity_matrix(frame.model);
 
     // SUN ANGLE ----------------------------------------------------------------------------------
     // setSunAngle(lightDirection, (double)(glfwGetTime() * 0.3));
-    lightPos[0] = sin(glfwGetTime() * 0.2) * atmosphereRadius;
-    lightPos[1] = 0.0f;
-    lightPos[2] = cos(glfwGetTime() * 0.2) * atmosphereRadius;
-    lightDirection[0] = lightPos[0];
-    lightDirection[2] = lightPos[2];
-
-    // render planet
-    glDepthMask(GL_TRUE); // Enable depth writing
-    glDepthFunc(GL_LESS); // Default depth test
-    glDisable(GL_BLEND);
-    glUseProgram(basicShader);
-    // set uniforms
-    // uniform mat4 model;
-    set_matrix_uniform(basicShader, "model", modelMatrix);
-    // uniform mat4 view;
-    set_matrix_uniform(basicShader, "view", viewMatrix);
-    // uniform mat4 projection;
-    set_matrix_uniform(basicShader, "projection", projectionMatrix);
-    // uniform vec3 lightPos;
-    set_vec3fv_uniform(basicShader, "lightPos", lightPos);
-    // uniform vec3 viewPos;
-    set_vec3fv_uniform(basicShader, "viewPos", camera.position);
-    // uniform vec3 surfaceColor;
-    set_vec3f_uniform(basicShader, "surfaceColor", 0.1f, 0.3f, 0.4f);
-
-    glBindVertexArray(vao);
-    renderSphereMesh(vao, indexCount);
-
-    // // render atmosphere
-    glDepthMask(GL_FALSE);                             // Disable depth writing
-    glEnable(GL_BLEND);                                // Enable blending for transparency
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA); // Standard blending function
-    glDepthFunc(GL_LEQUAL);                            // Allow atmosphere to render at equal or greater depth
-
-    glUseProgram(atmosphereShader);
-    // scale
-    // float sfac = atmosphereRadius / planetRadius;
-    // scaleMatrix4x4ColumnMajor(modelMatrix, sfac, sfac, sfac);
-    // uniform mat4 model;
-    set_matrix_uniform(atmosphereShader, "model", modelMatrix);
-    // uniform mat4 view;
-    set_matrix_uniform(atmosphereShader, "view", viewMatrix);
-    // uniform mat4 projection;
-    set_matrix_uniform(atmosphereShader, "projection", projectionMatrix);
-
-    // lighting uniforms
-
-    // set_vec3fv_uniform(atmosphereShader, "ulightDirection", lightDirection);
-    // set_float_uniform(atmosphereShader, "planetRadius", planetRadius);
-    // set_float_uniform(atmosphereShader, "atmosphereRadius", atmosphereRadius);
-    // // set_vec3fv_uniform(atmosphereShader, "rayleighCoefficient", rayleighCoefficient);
-    // set_vec3fv_uniform(atmosphereShader, "mieCoefficient", mieCoefficient);
-    // // set_vec3fv_uniform(atmosphereShader, "rayleighColorFactor", rayleighColorFactor);
-    // set_vec3fv_uniform(atmosphereShader, "mieColorFactor", mieColorFactor);
-    // set_float_uniform(atmosphereShader, "mieDirectionality", mieDirectionality);
-    // set_int_uniform(atmosphereShader, "numSamples", 32);
-    // set_int_uniform(atmosphereShader, "numLightSamples", 16);
-
-    // copy uniforms
-    set_vec3fv_uniform(atmosphereShader, "viewPos", camera.position);
-    set_vec3fv_uniform(atmosphereShader, "sunPos", lightDirection);
-    set_int_uniform(atmosphereShader, "viewSamples", 16);
-    set_int_uniform(atmosphereShader, "lightSamples", 8);
-    set_float_uniform(atmosphereShader, "sunIntensity", 20.0f);
-    set_float_uniform(atmosphereShader, "planetRadius", planetRadius);
-    set_float_uniform(atmosphereShader, "atmosphereRadius", atmosphereRadius);
-    set_vec3f_uniform(atmosphereShader, "rCoeff", 5.8e-3f, 13.5e-3f, 33.1e-3f);
-    set_float_uniform(atmosphereShader, "mCoeff", 21e-3f);
-    set_float_uniform(atmosphereShader, "rHeight", 7.994);
-    set_float_uniform(atmosphereShader, "mHeight", 1.200);
-    set_float_uniform(atmosphereShader, "g", 0.888);
-    set_float_uniform(atmosphereShader, "toneMappingFactor", 0.0);
-
-    // renderSphereMesh(avao, aindexCount);
-
-    glDepthMask(GL_TRUE);
-    glDisable(GL_BLEND);
-    glDepthFunc(GL_LESS);
-
+    vec3 sun = vec3_scale(vec3_make(sinf(sunAngle), 0.0f, cosf(sunAngle)), atmosphereRadius);
+    vec3_store(sun, lightPos);
+    lightDirection[0] = sun.x;
+    lightDirection[2] = sun.z;
+
+    memcpy(frame.lightPos, lightPos, sizeof(lightPos));
+    memcpy(frame.sunDirection, lightDirection, sizeof(lightDirection));
+    memcpy(frame.viewPos, camera.position, sizeof(camera.position));
+    frame.wireframe = drawWireframe;
+    frame.deltaTime = deltaTime;
+    frame.inputTime = pendingInputTime;
+    pendingInputTime = -1.0;
+
+    // planet, atmosphere, exposure and tone mapping passes
+    renderFrame(&renderer, &frame);
+
+    redraw.lastSunAngle = sunAngle;
+    redraw.dirty = 0;
     glfwSwapBuffers(window);
+    endFrame(&renderer);
+
+    if (benchmark.frames > 0 && !benchmarkFrame())
+    {
+      glfwSetWindowShouldClose(window, 1);
+      glfwPostEmptyEvent();
+      break;
+    }
   }
-  glfwDestroyWindow(window);
-  glfwTerminate();
-  return 0;
+  destroyRenderer(&renderer);
+  glfwMakeContextCurrent(NULL);
+  return NULL;
 }
 
+// GLFW callbacks run on the main thread and only forward events to the render thread
 void framebuffer_size_callback(GLFWwindow *window, int width, int height)
 {
-  glViewport(0, 0, width, height);
-  Width = width;
-  Height = height;
+  sendInputEvent((InputEvent){.type = INPUT_RESIZE, .width = width, .height = height});
 }
 
-void processInput(GLFWwindow *window)
+void key_callback(GLFWwindow *window, int key, int scancode, int action, int mods)
 {
-  float velocity = CAMERA_SPEED;
-
-  // Orbit Movement
-  if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+  (void)scancode;
+  (void)mods;
+  if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
     glfwSetWindowShouldClose(window, 1);
+  if (key < 0 || key > GLFW_KEY_LAST)
+    return;
+  sendInputEvent((InputEvent){.type = INPUT_KEY, .key = key, .action = action});
+}
+
+void window_refresh_callback(GLFWwindow *window)
+{
+  (void)window;
+  sendInputEvent((InputEvent){.type = INPUT_REFRESH});
+}
+
+void mouse_callback(GLFWwindow *window, double xpos, double ypos)
+{
+  sendInputEvent((InputEvent){.type = INPUT_CURSOR, .x = xpos, .y = ypos});
+}
+
+void handleInputEvent(const InputEvent *event)
+{
+  switch (event->type)
+  {
+  case INPUT_RESIZE:
+    glViewport(0, 0, event->width, event->height);
+    Width = event->width;
+    Height = event->height;
+    redraw.resized = 1;
+    redraw.dirty = 1;
+    break;
+  case INPUT_KEY:
+    keyDown[event->key] = event->action != GLFW_RELEASE;
+    if (event->action != GLFW_PRESS)
+      break;
+    if (event->key == GLFW_KEY_TAB)
+    {
+      drawWireframe = !drawWireframe;
+      redraw.dirty = 1;
+    }
+    if (event->key == GLFW_KEY_F1)
+    {
+      cycleDebugView(&renderer);
+      redraw.dirty = 1;
+    }
+    if (event->key == GLFW_KEY_F2)
+    {
+      setAntialiasing(&renderer, (renderer.settings.antialiasing + 1) % AA_MODE_COUNT);
+      printf("Antialiasing: %s\n", antialiasingName(renderer.settings.antialiasing));
+      redraw.dirty = 1;
+    }
+    break;
+  case INPUT_CURSOR:
+    mouseMoved(event->x, event->y);
+    break;
+  case INPUT_REFRESH:
+    // window contents were damaged (expose, restore), the last frame has to be drawn again
+    redraw.dirty = 1;
+    break;
+  }
+}
+
+// returns 1 while a movement key is held so the on-demand loop keeps polling
+int processInput(void)
+{
+  vec3 position = vec3_load(camera.position);
+  vec3 forward = vec3_scale(vec3_load(camera.forward), CAMERA_SPEED);
+  vec3 side = vec3_scale(vec3_normalize(vec3_cross(vec3_load(camera.forward), vec3_load(camera.up))), CAMERA_SPEED);
+  int moved = 0;
 
-  if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+  // Orbit Movement
+  if (keyDown[GLFW_KEY_W])
   {
-    camera.position[0] += camera.forward[0] * velocity;
-    camera.position[1] += camera.forward[1] * velocity;
-    camera.position[2] += camera.forward[2] * velocity;
+    moved = 1;
+    position = vec3_add(position, forward);
   }
-  if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+  if (keyDown[GLFW_KEY_S])
   {
-    camera.position[0] -= camera.forward[0] * velocity;
-    camera.position[1] -= camera.forward[1] * velocity;
-    camera.position[2] -= camera.forward[2] * velocity;
+    moved = 1;
+    position = vec3_sub(position, forward);
   }
-  if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+  if (keyDown[GLFW_KEY_D])
   {
-    float factor[3];
-    crossProduct(camera.forward, camera.up, factor);
-    normalize(factor);
-    factor[0] *= velocity;
-    factor[1] *= velocity;
-    factor[2] *= velocity;
-    camera.position[0] -= factor[0];
-    camera.position[1] -= factor[1];
-    camera.position[2] -= factor[2];
+    moved = 1;
+    position = vec3_sub(position, side);
   }
-  if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+  if (keyDown[GLFW_KEY_A])
   {
-    float factor[3];
-    crossProduct(camera.forward, camera.up, factor);
-    normalize(factor);
-    factor[0] *= velocity;
-    factor[1] *= velocity;
-    factor[2] *= velocity;
-    camera.position[0] += factor[0];
-    camera.position[1] += factor[1];
-    camera.position[2] += factor[2];
+    moved = 1;
+    position = vec3_add(position, side);
   }
+  vec3_store(position, camera.position);
+  return moved;
 }
-void mouse_callback(GLFWwindow *window, double xpos, double ypos)
+void mouseMoved(double xpos, double ypos)
 {
   if (firstMouse)
   {
@@ -315,4 +494,41 @@ void mouse_callback(GLFWwindow *window, double xpos, double ypos)
     camera.pitch = -89.0f;
 
   updateCameraVectors(&camera);
-}
\ No newline at end of file
+  redraw.dirty = 1;
+}
+
+// counts a presented frame, returns 0 once every mode has been measured
+int benchmarkFrame(void)
+{
+  benchmark.frame++;
+  if (benchmark.frame == BENCHMARK_WARMUP_FRAMES)
+  {
+    // retire the warmup frames before measuring
+    glFinish();
+    beginFrame(&renderer);
+    resetTimingStats(&renderer.gpuTime);
+    benchmark.start = glfwGetTime();
+  }
+  if (benchmark.frame < BENCHMARK_WARMUP_FRAMES + benchmark.frames)
+    return 1;
+
+  // wait for the last frames so all their timer queries are read back
+  glFinish();
+  beginFrame(&renderer);
+  benchmark.frameTime[benchmark.mode] = (glfwGetTime() - benchmark.start) / benchmark.frames;
+  benchmark.gpuTime[benchmark.mode] = renderer.gpuTime.count ? renderer.gpuTime.sum / renderer.gpuTime.count : 0.0;
+
+  benchmark.mode++;
+  benchmark.frame = 0;
+  if (benchmark.mode < AA_MODE_COUNT)
+  {
+    setAntialiasing(&renderer, benchmark.mode);
+    return 1;
+  }
+
+  printf("Benchmark %dx%d, %d frames per mode\n", Width, Height, benchmark.frames);
+  printf("  %-6s %10s %10s\n", "aa", "gpu ms", "frame ms");
+  for (int mode = 0; mode < AA_MODE_COUNT; mode++)
+    printf("  %-6s %10.3f %10.3f\n", antialiasingName(mode), benchmark.gpuTime[mode] * 1000.0, benchmark.frameTime[mode] * 1000.0);
+  return 0;
+}
@@ -18,74 +18,32 @@ void printVec3(const float vector[3])
   printf("%.2f ", vector[2]);
   printf("\n");
 }
+// thin wrappers over the inline value types in vecmath.h
 float radians(float degrees)
 {
-  return degrees * (M_PI / 180.0f);
+  return to_radians(degrees);
 }
 void normalize(float *v)
 {
-  float length = sqrtf(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
-  if (length > 0)
-  {
-    v[0] /= length;
-    v[1] /= length;
-    v[2] /= length;
-  }
+  vec3_store(vec3_normalize(vec3_load(v)), v);
 }
 void crossProduct(float *A, float *B, float *Result)
 {
-  Result[0] = A[1] * B[2] - A[2] * B[1]; // Result.x
-  Result[1] = A[2] * B[0] - A[0] * B[2]; // Result.y
-  Result[2] = A[0] * B[1] - A[1] * B[0]; // Result.z
-}
-void multiplyMatrices4x4(const float A[16], const float B[16], float result[16])
-{
-  for (int i = 0; i < 4; i++)
-  {
-    for (int j = 0; j < 4; j++)
-    {
-      result[i * 4 + j] = 0; // Initialize result element
-      for (int k = 0; k < 4; k++)
-      {
-        result[i * 4 + j] += A[i * 4 + k] * B[k * 4 + j]; // Perform multiplication and sum
-      }
-    }
-  }
+  vec3_store(vec3_cross(vec3_load(A), vec3_load(B)), Result);
 }
 void addVectors(const float A[3], const float B[3], float result[3])
 {
-  result[0] = A[0] + B[0];
-  result[1] = A[1] + B[1];
-  result[2] = A[2] + B[2];
+  vec3_store(vec3_add(vec3_load(A), vec3_load(B)), result);
 }
 void subtractVectors(const float A[3], const float B[3], float result[3])
 {
-  result[0] = A[0] - B[0];
-  result[1] = A[1] - B[1];
-  result[2] = A[2] - B[2];
+  vec3_store(vec3_sub(vec3_load(A), vec3_load(B)), result);
 }
 // basic matrix functions
 void create_identity_matrix(float *matrix)
 {
-  matrix[0] = 1; // Row 0, Column 0
-  matrix[1] = 0; // Row 0, Column 1
-  matrix[2] = 0; // Row 0, Column 2
-  matrix[3] = 0; // Row 0, Column 3
-
-  matrix[4] = 0; // Row 1, Column 0
-  matrix[5] = 1; // Row 1, Column 1
-  matrix[6] = 0; // Row 1, Column 2
-  matrix[7] = 0; // Row 1, Column 3
-
-  matrix[8] = 0;  // Row 2, Column 0
-  matrix[9] = 0;  // Row 2, Column 1
-  matrix[10] = 1; // Row 2, Column 2
-  matrix[11] = 0; // Row 2, Column 3
-
-  matrix[12] = 0; // Row 3, Column 0
-  matrix[13] = 0; // Row 3, Column 1
-  matrix[14] = 0; // Row 3, Column 2
-  matrix[15] = 1; // Row 3, Column 3
+  static const mat4 identity = MAT4_IDENTITY_INIT;
+  mat4_store(&identity, matrix);
 }
 void translateMatrix(float *matrix, float tx, float ty, float tz)
 {
@@ -101,12 +59,39 @@ void scaleMatrix4x4ColumnMajor(float *matrix, float sx, float sy, float sz)
   matrix[10] = sz;   // Scale z-axis
   matrix[15] = 1.0f; // Homogeneous coordinate
 }
+int create_normal_matrix(const float model[16], float normalMatrix[9])
+{
+  // for a 3x3 matrix with columns a, b, c the inverse transpose is [b x c, c x a, a x b] / det
+  float a[3] = {model[0], model[1], model[2]};
+  float b[3] = {model[4], model[5], model[6]};
+  float c[3] = {model[8], model[9], model[10]};
+  float bc[3], ca[3], ab[3];
+  crossProduct(b, c, bc);
+  crossProduct(c, a, ca);
+  crossProduct(a, b, ab);
+
+  float det = a[0] * bc[0] + a[1] * bc[1] + a[2] * bc[2];
+  if (fabsf(det) < 1e-20f)
+    return 0;
+  float invDet = 1.0f / det;
+  for (int i = 0; i < 3; i++)
+  {
+    normalMatrix[0 + i] = bc[i] * invDet;
+    normalMatrix[3 + i] = ca[i] * invDet;
+    normalMatrix[6 + i] = ab[i] * invDet;
+  }
+  return 1;
+}
 
 // perspective matrix
 void create_perspective_matrix(float fov, float aspect, float near, float far, float *matrix)
+{
+  mat4 perspective = mat4_perspective(fov, aspect, near, far);
+  mat4_store(&perspective, matrix);
+}
+void create_reversed_perspective_matrix(float fov, float aspect, float near, float *matrix)
 {
   float f = 1.0f / tanf(fov / 2.0f); // Calculate the cotangent of the angle
-  float nf = 1.0f / (near - far);
 
   matrix[0] = f / aspect;
   matrix[1] = 0.0f;
@@ -118,15 +103,16 @@ void create_perspective_matrix(float fov, float aspect, float near, float far, f
   matrix[6] = 0.0f;
   matrix[7] = 0.0f;
 
+  // depth = near / -z, precision is spread evenly by the float depth buffer
   matrix[8] = 0.0f;
   matrix[9] = 0.0f;
-  matrix[10] = (far + near) * nf;
+  matrix[10] = 0.0f;
   matrix[11] = -1.0f;
 
   matrix[12] = 0.0f;
   matrix[13] = 0.0f;
-  matrix[14] = (2 * far * near) * nf;
-  matrix[15] = 0.0f; // Row 3, Column 3
+  matrix[14] = near;
+  matrix[15] = 0.0f;
 }
 
 // view matrix
@@ -213,6 +199,545 @@ void updateCameraVectors(Camera *camera)
   addVectors(camera->position, camera->forward, camera->target);
 }
 
+// batched kernels
+// x86 builds carry SSE and AVX versions compiled through target attributes, the widest one the
+// CPU supports is picked on first use. Everything else runs the scalar code.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define MATH_X86 1
+#include <immintrin.h>
+#define TARGET_SSE __attribute__((target("sse2")))
+#define TARGET_AVX __attribute__((target("avx")))
+#endif
+
+typedef struct
+{
+  MathKernels level;
+  void (*multiply4x4)(const float A[16], const float B[16], float result[16]);
+  void (*transform4)(const float matrix[16], const float *vectors, float *result, int count);
+  void (*normalize3)(float *vectors, int count);
+  void (*cullSpheres)(const float planes[6][4], const float *spheres, int count, unsigned char *visible);
+  void (*cullBoxes)(const float planes[6][4], const float *boxes, int count, unsigned char *visible);
+  void (*transpose4x4)(const float matrix[16], float result[16]);
+  int (*invert4x4)(const float matrix[16], float result[16]);
+} MathKernelTable;
+
+static void multiplyMatrices4x4Scalar(const float A[16], const float B[16], float result[16])
+{
+  for (int i = 0; i < 4; i++)
+  {
+    for (int j = 0; j < 4; j++)
+    {
+      result[i * 4 + j] = 0; // Initialize result element
+      for (int k = 0; k < 4; k++)
+      {
+        result[i * 4 + j] += A[i * 4 + k] * B[k * 4 + j]; // Perform multiplication and sum
+      }
+    }
+  }
+}
+static void transformVectors4Scalar(const float m[16], const float *vectors, float *result, int count)
+{
+  for (int i = 0; i < count; i++)
+  {
+    const float *v = vectors + i * 4;
+    float x = v[0], y = v[1], z = v[2], w = v[3];
+    float *r = result + i * 4;
+    r[0] = m[0] * x + m[4] * y + m[8] * z + m[12] * w;
+    r[1] = m[1] * x + m[5] * y + m[9] * z + m[13] * w;
+    r[2] = m[2] * x + m[6] * y + m[10] * z + m[14] * w;
+    r[3] = m[3] * x + m[7] * y + m[11] * z + m[15] * w;
+  }
+}
+static void normalizeVectorsScalar(float *vectors, int count)
+{
+  for (int i = 0; i < count; i++)
+    normalize(vectors + i * 3);
+}
+static void cullSpheresScalar(const float planes[6][4], const float *spheres, int count, unsigned char *visible)
+{
+  for (int i = 0; i < count; i++)
+  {
+    const float *s = spheres + i * 4;
+    int inside = 1;
+    for (int p = 0; p < 6 && inside; p++)
+      inside = planes[p][0] * s[0] + planes[p][1] * s[1] + planes[p][2] * s[2] + planes[p][3] > -s[3];
+    visible[i] = inside;
+  }
+}
+static void cullBoxesScalar(const float planes[6][4], const float *boxes, int count, unsigned char *visible)
+{
+  for (int i = 0; i < count; i++)
+  {
+    const float *b = boxes + i * 6;
+    int inside = 1;
+    for (int p = 0; p < 6 && inside; p++)
+    {
+      // corner furthest along the plane normal
+      float x = planes[p][0] >= 0.0f ? b[3] : b[0];
+      float y = planes[p][1] >= 0.0f ? b[4] : b[1];
+      float z = planes[p][2] >= 0.0f ? b[5] : b[2];
+      inside = planes[p][0] * x + planes[p][1] * y + planes[p][2] * z + planes[p][3] >= 0.0f;
+    }
+    visible[i] = inside;
+  }
+}
+
+static void transposeMatrix4x4Scalar(const float matrix[16], float result[16])
+{
+  for (int i = 0; i < 4; i++)
+  {
+    for (int j = 0; j < 4; j++)
+    {
+      result[j * 4 + i] = matrix[i * 4 + j];
+    }
+  }
+}
+static int invertMatrix4x4Scalar(const float m[16], float result[16])
+{
+  // 2x2 determinants of the first two and last two rows (columns for column-major input,
+  // the inverse of a transpose is the transpose of the inverse so the layout does not matter)
+  float s0 = m[0] * m[5] - m[4] * m[1];
+  float s1 = m[0] * m[6] - m[4] * m[2];
+  float s2 = m[0] * m[7] - m[4] * m[3];
+  float s3 = m[1] * m[6] - m[5] * m[2];
+  float s4 = m[1] * m[7] - m[5] * m[3];
+  float s5 = m[2] * m[7] - m[6] * m[3];
+
+  float c5 = m[10] * m[15] - m[14] * m[11];
+  float c4 = m[9] * m[15] - m[13] * m[11];
+  float c3 = m[9] * m[14] - m[13] * m[10];
+  float c2 = m[8] * m[15] - m[12] * m[11];
+  float c1 = m[8] * m[14] - m[12] * m[10];
+  float c0 = m[8] * m[13] - m[12] * m[9];
+
+  float det = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+  if (fabsf(det) < 1e-20f)
+    return 0;
+  float invDet = 1.0f / det;
+
+  float inv[16];
+  inv[0] = (m[5] * c5 - m[6] * c4 + m[7] * c3) * invDet;
+  inv[1] = (-m[1] * c5 + m[2] * c4 - m[3] * c3) * invDet;
+  inv[2] = (m[13] * s5 - m[14] * s4 + m[15] * s3) * invDet;
+  inv[3] = (-m[9] * s5 + m[10] * s4 - m[11] * s3) * invDet;
+
+  inv[4] = (-m[4] * c5 + m[6] * c2 - m[7] * c1) * invDet;
+  inv[5] = (m[0] * c5 - m[2] * c2 + m[3] * c1) * invDet;
+  inv[6] = (-m[12] * s5 + m[14] * s2 - m[15] * s1) * invDet;
+  inv[7] = (m[8] * s5 - m[10] * s2 + m[11] * s1) * invDet;
+
+  inv[8] = (m[4] * c4 - m[5] * c2 + m[7] * c0) * invDet;
+  inv[9] = (-m[0] * c4 + m[1] * c2 - m[3] * c0) * invDet;
+  inv[10] = (m[12] * s4 - m[13] * s2 + m[15] * s0) * invDet;
+  inv[11] = (-m[8] * s4 + m[9] * s2 - m[11] * s0) * invDet;
+
+  inv[12] = (-m[4] * c3 + m[5] * c1 - m[6] * c0) * invDet;
+  inv[13] = (m[0] * c3 - m[1] * c1 + m[2] * c0) * invDet;
+  inv[14] = (-m[12] * s3 + m[13] * s1 - m[14] * s0) * invDet;
+  inv[15] = (m[8] * s3 - m[9] * s1 + m[10] * s0) * invDet;
+
+  for (int i = 0; i < 16; i++)
+    result[i] = inv[i];
+  return 1;
+}
+
+#ifdef MATH_X86
+TARGET_SSE static void multiplyMatrices4x4SSE(const float A[16], const float B[16], float result[16])
+{
+  __m128 b0 = _mm_loadu_ps(B), b1 = _mm_loadu_ps(B + 4), b2 = _mm_loadu_ps(B + 8), b3 = _mm_loadu_ps(B + 12);
+  for (int i = 0; i < 4; i++)
+  {
+    // row i of the result is a combination of the rows of B
+    __m128 row = _mm_mul_ps(_mm_set1_ps(A[i * 4 + 0]), b0);
+    row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(A[i * 4 + 1]), b1));
+    row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(A[i * 4 + 2]), b2));
+    row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(A[i * 4 + 3]), b3));
+    _mm_storeu_ps(result + i * 4, row);
+  }
+}
+TARGET_SSE static void transformVectors4SSE(const float m[16], const float *vectors, float *result, int count)
+{
+  __m128 c0 = _mm_loadu_ps(m), c1 = _mm_loadu_ps(m + 4), c2 = _mm_loadu_ps(m + 8), c3 = _mm_loadu_ps(m + 12);
+  for (int i = 0; i < count; i++)
+  {
+    __m128 v = _mm_loadu_ps(vectors + i * 4);
+    __m128 r = _mm_mul_ps(c0, _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0)));
+    r = _mm_add_ps(r, _mm_mul_ps(c1, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1))));
+    r = _mm_add_ps(r, _mm_mul_ps(c2, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2))));
+    r = _mm_add_ps(r, _mm_mul_ps(c3, _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3))));
+    _mm_storeu_ps(result + i * 4, r);
+  }
+}
+TARGET_SSE static void normalizeVectorsSSE(float *vectors, int count)
+{
+  int i = 0;
+  for (; i + 4 <= count; i += 4)
+  {
+    // four packed vec3: a = x0 y0 z0 x1, b = y1 z1 x2 y2, c = z2 x3 y3 z3
+    float *v = vectors + i * 3;
+    __m128 a = _mm_loadu_ps(v), b = _mm_loadu_ps(v + 4), c = _mm_loadu_ps(v + 8);
+    __m128 x = _mm_shuffle_ps(a, _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2)), _MM_SHUFFLE(2, 0, 3, 0));
+    __m128 y = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1)), _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+    __m128 z = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2)), c, _MM_SHUFFLE(3, 0, 2, 0));
+    __m128 lengthSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+
+    // zero length vectors are left as they are, like normalize()
+    __m128 nonZero = _mm_cmpgt_ps(lengthSquared, _mm_setzero_ps());
+    __m128 scale = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(lengthSquared));
+    scale = _mm_or_ps(_mm_and_ps(nonZero, scale), _mm_andnot_ps(nonZero, _mm_set1_ps(1.0f)));
+
+    // spread the four scales over the packed layout instead of unpacking the vectors again
+    _mm_storeu_ps(v, _mm_mul_ps(a, _mm_shuffle_ps(scale, scale, _MM_SHUFFLE(1, 0, 0, 0))));
+    _mm_storeu_ps(v + 4, _mm_mul_ps(b, _mm_shuffle_ps(scale, scale, _MM_SHUFFLE(2, 2, 1, 1))));
+    _mm_storeu_ps(v + 8, _mm_mul_ps(c, _mm_shuffle_ps(scale, scale, _MM_SHUFFLE(3, 3, 3, 2))));
+  }
+  normalizeVectorsScalar(vectors + i * 3, count - i);
+}
+TARGET_SSE static void cullSpheresSSE(const float planes[6][4], const float *spheres, int count, unsigned char *visible)
+{
+  int i = 0;
+  for (; i + 4 <= count; i += 4)
+  {
+    // four spheres to x, y, z, radius lanes
+    __m128 x = _mm_loadu_ps(spheres + i * 4), y = _mm_loadu_ps(spheres + i * 4 + 4);
+    __m128 z = _mm_loadu_ps(spheres + i * 4 + 8), r = _mm_loadu_ps(spheres + i * 4 + 12);
+    _MM_TRANSPOSE4_PS(x, y, z, r);
+    __m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), r);
+
+    __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+    for (int p = 0; p < 6; p++)
+    {
+      __m128 distance = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes[p][0]), x), _mm_mul_ps(_mm_set1_ps(planes[p][1]), y));
+      distance = _mm_add_ps(distance, _mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes[p][2]), z), _mm_set1_ps(planes[p][3])));
+      inside = _mm_and_ps(inside, _mm_cmpgt_ps(distance, negativeRadius));
+    }
+    int mask = _mm_movemask_ps(inside);
+    for (int j = 0; j < 4; j++)
+      visible[i + j] = (mask >> j) & 1;
+  }
+  cullSpheresScalar(planes, spheres + i * 4, count - i, visible + i);
+}
+TARGET_SSE static void cullBoxesSSE(const float planes[6][4], const float *boxes, int count, unsigned char *visible)
+{
+  // planes are tested four at a time, padded to eight with planes every box passes
+  float soa[4][8] = {{0.0f}};
+  for (int p = 0; p < 8; p++)
+  {
+    for (int k = 0; k < 4; k++)
+      soa[k][p] = p < 6 ? planes[p][k] : (k == 3 ? 1.0f : 0.0f);
+  }
+  __m128 nx[2], ny[2], nz[2], d[2], px[2], py[2], pz[2];
+  for (int h = 0; h < 2; h++)
+  {
+    nx[h] = _mm_loadu_ps(soa[0] + h * 4);
+    ny[h] = _mm_loadu_ps(soa[1] + h * 4);
+    nz[h] = _mm_loadu_ps(soa[2] + h * 4);
+    d[h] = _mm_loadu_ps(soa[3] + h * 4);
+    px[h] = _mm_cmpge_ps(nx[h], _mm_setzero_ps());
+    py[h] = _mm_cmpge_ps(ny[h], _mm_setzero_ps());
+    pz[h] = _mm_cmpge_ps(nz[h], _mm_setzero_ps());
+  }
+
+  for (int i = 0; i < count; i++)
+  {
+    const float *b = boxes + i * 6;
+    __m128 minX = _mm_set1_ps(b[0]), minY = _mm_set1_ps(b[1]), minZ = _mm_set1_ps(b[2]);
+    __m128 maxX = _mm_set1_ps(b[3]), maxY = _mm_set1_ps(b[4]), maxZ = _mm_set1_ps(b[5]);
+    __m128 outside = _mm_setzero_ps();
+    for (int h = 0; h < 2; h++)
+    {
+      // corner furthest along each plane normal
+      __m128 x = _mm_or_ps(_mm_and_ps(px[h], maxX), _mm_andnot_ps(px[h], minX));
+      __m128 y = _mm_or_ps(_mm_and_ps(py[h], maxY), _mm_andnot_ps(py[h], minY));
+      __m128 z = _mm_or_ps(_mm_and_ps(pz[h], maxZ), _mm_andnot_ps(pz[h], minZ));
+      __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx[h], x), _mm_mul_ps(ny[h], y)),
+                                   _mm_add_ps(_mm_mul_ps(nz[h], z), d[h]));
+      outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, _mm_setzero_ps()));
+    }
+    visible[i] = _mm_movemask_ps(outside) == 0;
+  }
+}
+
+TARGET_SSE static void transposeMatrix4x4SSE(const float matrix[16], float result[16])
+{
+  __m128 c0 = _mm_loadu_ps(matrix), c1 = _mm_loadu_ps(matrix + 4), c2 = _mm_loadu_ps(matrix + 8), c3 = _mm_loadu_ps(matrix + 12);
+  _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+  _mm_storeu_ps(result, c0);
+  _mm_storeu_ps(result + 4, c1);
+  _mm_storeu_ps(result + 8, c2);
+  _mm_storeu_ps(result + 12, c3);
+}
+
+// lanes listed in register order, _MM_SHUFFLE takes them the other way round
+#define LANES(x, y, z, w) _MM_SHUFFLE(w, z, y, x)
+#define SWIZZLE(v, x, y, z, w) _mm_shuffle_ps(v, v, LANES(x, y, z, w))
+
+// 2x2 matrices stored (m00, m01, m10, m11) in one register
+TARGET_SSE static inline __m128 mat2Mul(__m128 a, __m128 b)
+{
+  return _mm_add_ps(_mm_mul_ps(a, SWIZZLE(b, 0, 3, 0, 3)), _mm_mul_ps(SWIZZLE(a, 1, 0, 3, 2), SWIZZLE(b, 2, 1, 2, 1)));
+}
+// adjugate(a) * b
+TARGET_SSE static inline __m128 mat2AdjMul(__m128 a, __m128 b)
+{
+  return _mm_sub_ps(_mm_mul_ps(SWIZZLE(a, 3, 3, 0, 0), b), _mm_mul_ps(SWIZZLE(a, 1, 1, 2, 2), SWIZZLE(b, 2, 3, 0, 1)));
+}
+// a * adjugate(b)
+TARGET_SSE static inline __m128 mat2MulAdj(__m128 a, __m128 b)
+{
+  return _mm_sub_ps(_mm_mul_ps(a, SWIZZLE(b, 3, 0, 3, 0)), _mm_mul_ps(SWIZZLE(a, 1, 0, 3, 2), SWIZZLE(b, 2, 1, 2, 1)));
+}
+
+// block inverse over the four 2x2 quadrants: the cofactors come out of 2x2 products and
+// adjugates that each fill a register, instead of the scalar version's 16 separate dot products
+TARGET_SSE static int invertMatrix4x4SSE(const float matrix[16], float result[16])
+{
+  __m128 r0 = _mm_loadu_ps(matrix), r1 = _mm_loadu_ps(matrix + 4), r2 = _mm_loadu_ps(matrix + 8), r3 = _mm_loadu_ps(matrix + 12);
+  __m128 a = _mm_movelh_ps(r0, r1), b = _mm_movehl_ps(r1, r0);
+  __m128 c = _mm_movelh_ps(r2, r3), d = _mm_movehl_ps(r3, r2);
+
+  // determinants of the quadrants as (|A| |B| |C| |D|)
+  __m128 detSub = _mm_sub_ps(_mm_mul_ps(_mm_shuffle_ps(r0, r2, LANES(0, 2, 0, 2)), _mm_shuffle_ps(r1, r3, LANES(1, 3, 1, 3))),
+                             _mm_mul_ps(_mm_shuffle_ps(r0, r2, LANES(1, 3, 1, 3)), _mm_shuffle_ps(r1, r3, LANES(0, 2, 0, 2))));
+  __m128 detA = SWIZZLE(detSub, 0, 0, 0, 0), detB = SWIZZLE(detSub, 1, 1, 1, 1);
+  __m128 detC = SWIZZLE(detSub, 2, 2, 2, 2), detD = SWIZZLE(detSub, 3, 3, 3, 3);
+
+  __m128 dc = mat2AdjMul(d, c);
+  __m128 ab = mat2AdjMul(a, b);
+  // adjugates of the inverse's quadrants, scaled by |M|
+  __m128 x = _mm_sub_ps(_mm_mul_ps(detD, a), mat2Mul(b, dc));
+  __m128 w = _mm_sub_ps(_mm_mul_ps(detA, d), mat2Mul(c, ab));
+  __m128 y = _mm_sub_ps(_mm_mul_ps(detB, c), mat2MulAdj(d, ab));
+  __m128 z = _mm_sub_ps(_mm_mul_ps(detC, b), mat2MulAdj(a, dc));
+
+  // |M| = |A| |D| + |B| |C| - tr(adj(A) B adj(D) C)
+  __m128 trace = _mm_mul_ps(ab, SWIZZLE(dc, 0, 2, 1, 3));
+  trace = _mm_add_ps(trace, SWIZZLE(trace, 2, 3, 0, 1));
+  trace = _mm_add_ss(trace, SWIZZLE(trace, 1, 0, 3, 2));
+  float det = _mm_cvtss_f32(_mm_sub_ss(_mm_add_ss(_mm_mul_ss(detA, detD), _mm_mul_ss(detB, detC)), trace));
+  if (fabsf(det) < 1e-20f)
+    return 0;
+
+  __m128 scale = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), _mm_set1_ps(det));
+  x = _mm_mul_ps(x, scale);
+  y = _mm_mul_ps(y, scale);
+  z = _mm_mul_ps(z, scale);
+  w = _mm_mul_ps(w, scale);
+
+  // undo the adjugates while storing the quadrants back as rows
+  _mm_storeu_ps(result, _mm_shuffle_ps(x, y, LANES(3, 1, 3, 1)));
+  _mm_storeu_ps(result + 4, _mm_shuffle_ps(x, y, LANES(2, 0, 2, 0)));
+  _mm_storeu_ps(result + 8, _mm_shuffle_ps(z, w, LANES(3, 1, 3, 1)));
+  _mm_storeu_ps(result + 12, _mm_shuffle_ps(z, w, LANES(2, 0, 2, 0)));
+  return 1;
+}
+#undef SWIZZLE
+#undef LANES
+
+TARGET_AVX static void multiplyMatrices4x4AVX(const float A[16], const float B[16], float result[16])
+{
+  __m256 b0 = _mm256_broadcast_ps((const __m128 *)B), b1 = _mm256_broadcast_ps((const __m128 *)(B + 4));
+  __m256 b2 = _mm256_broadcast_ps((const __m128 *)(B + 8)), b3 = _mm256_broadcast_ps((const __m128 *)(B + 12));
+  for (int i = 0; i < 4; i += 2)
+  {
+    // two rows per iteration, one in each 128-bit lane
+    __m256 a = _mm256_loadu_ps(A + i * 4);
+    __m256 rows = _mm256_mul_ps(_mm256_shuffle_ps(a, a, _MM_SHUFFLE(0, 0, 0, 0)), b0);
+    rows = _mm256_add_ps(rows, _mm256_mul_ps(_mm256_shuffle_ps(a, a, _MM_SHUFFLE(1, 1, 1, 1)), b1));
+    rows = _mm256_add_ps(rows, _mm256_mul_ps(_mm256_shuffle_ps(a, a, _MM_SHUFFLE(2, 2, 2, 2)), b2));
+    rows = _mm256_add_ps(rows, _mm256_mul_ps(_mm256_shuffle_ps(a, a, _MM_SHUFFLE(3, 3, 3, 3)), b3));
+    _mm256_storeu_ps(result + i * 4, rows);
+  }
+}
+TARGET_AVX static void transformVectors4AVX(const float m[16], const float *vectors, float *result, int count)
+{
+  __m256 c0 = _mm256_broadcast_ps((const __m128 *)m), c1 = _mm256_broadcast_ps((const __m128 *)(m + 4));
+  __m256 c2 = _mm256_broadcast_ps((const __m128 *)(m + 8)), c3 = _mm256_broadcast_ps((const __m128 *)(m + 12));
+  int i = 0;
+  for (; i + 2 <= count; i += 2)
+  {
+    __m256 v = _mm256_loadu_ps(vectors + i * 4);
+    __m256 r = _mm256_mul_ps(c0, _mm256_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0)));
+    r = _mm256_add_ps(r, _mm256_mul_ps(c1, _mm256_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1))));
+    r = _mm256_add_ps(r, _mm256_mul_ps(c2, _mm256_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2))));
+    r = _mm256_add_ps(r, _mm256_mul_ps(c3, _mm256_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3))));
+    _mm256_storeu_ps(result + i * 4, r);
+  }
+  transformVectors4Scalar(m, vectors + i * 4, result + i * 4, count - i);
+}
+TARGET_AVX static void cullSpheresAVX(const float planes[6][4], const float *spheres, int count, unsigned char *visible)
+{
+  int i = 0;
+  for (; i + 8 <= count; i += 8)
+  {
+    // spheres 0-3 in the low lanes and 4-7 in the high lanes, transposed per lane
+    const float *s = spheres + i * 4;
+    __m256 s0 = _mm256_loadu2_m128(s + 16, s), s1 = _mm256_loadu2_m128(s + 20, s + 4);
+    __m256 s2 = _mm256_loadu2_m128(s + 24, s + 8), s3 = _mm256_loadu2_m128(s + 28, s + 12);
+    __m256 t0 = _mm256_unpacklo_ps(s0, s1), t1 = _mm256_unpacklo_ps(s2, s3);
+    __m256 t2 = _mm256_unpackhi_ps(s0, s1), t3 = _mm256_unpackhi_ps(s2, s3);
+    __m256 x = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(1, 0, 1, 0));
+    __m256 y = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(3, 2, 3, 2));
+    __m256 z = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(1, 0, 1, 0));
+    __m256 r = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(3, 2, 3, 2));
+    __m256 negativeRadius = _mm256_sub_ps(_mm256_setzero_ps(), r);
+
+    __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+    for (int p = 0; p < 6; p++)
+    {
+      __m256 distance = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(planes[p][0]), x), _mm256_mul_ps(_mm256_set1_ps(planes[p][1]), y));
+      distance = _mm256_add_ps(distance, _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(planes[p][2]), z), _mm256_set1_ps(planes[p][3])));
+      inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, negativeRadius, _CMP_GT_OQ));
+    }
+    int mask = _mm256_movemask_ps(inside);
+    for (int j = 0; j < 8; j++)
+      visible[i + j] = (mask >> j) & 1;
+  }
+  cullSpheresScalar(planes, spheres + i * 4, count - i, visible + i);
+}
+TARGET_AVX static void cullBoxesAVX(const float planes[6][4], const float *boxes, int count, unsigned char *visible)
+{
+  // all six planes in one register, padded with two planes every box passes
+  float soa[4][8];
+  for (int p = 0; p < 8; p++)
+  {
+    for (int k = 0; k < 4; k++)
+      soa[k][p] = p < 6 ? planes[p][k] : (k == 3 ? 1.0f : 0.0f);
+  }
+  __m256 nx = _mm256_loadu_ps(soa[0]), ny = _mm256_loadu_ps(soa[1]), nz = _mm256_loadu_ps(soa[2]), d = _mm256_loadu_ps(soa[3]);
+  __m256 px = _mm256_cmp_ps(nx, _mm256_setzero_ps(), _CMP_GE_OQ);
+  __m256 py = _mm256_cmp_ps(ny, _mm256_setzero_ps(), _CMP_GE_OQ);
+  __m256 pz = _mm256_cmp_ps(nz, _mm256_setzero_ps(), _CMP_GE_OQ);
+
+  for (int i = 0; i < count; i++)
+  {
+    const float *b = boxes + i * 6;
+    __m256 x = _mm256_blendv_ps(_mm256_set1_ps(b[0]), _mm256_set1_ps(b[3]), px);
+    __m256 y = _mm256_blendv_ps(_mm256_set1_ps(b[1]), _mm256_set1_ps(b[4]), py);
+    __m256 z = _mm256_blendv_ps(_mm256_set1_ps(b[2]), _mm256_set1_ps(b[5]), pz);
+    __m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(nx, x), _mm256_mul_ps(ny, y)),
+                                    _mm256_add_ps(_mm256_mul_ps(nz, z), d));
+    visible[i] = _mm256_movemask_ps(_mm256_cmp_ps(distance, _mm256_setzero_ps(), _CMP_LT_OQ)) == 0;
+  }
+}
+#endif
+
+static MathKernelTable kernels;
+
+static int kernelsSupported(MathKernels level)
+{
+#ifdef MATH_X86
+  __builtin_cpu_init();
+  if (level == MATH_KERNELS_AVX)
+    return __builtin_cpu_supports("avx");
+  if (level == MATH_KERNELS_SSE)
+    return __builtin_cpu_supports("sse2");
+#endif
+  return level == MATH_KERNELS_SCALAR;
+}
+
+int setMathKernels(MathKernels level)
+{
+  if (!kernelsSupported(level))
+    return 0;
+
+  MathKernelTable table = {MATH_KERNELS_SCALAR, multiplyMatrices4x4Scalar, transformVectors4Scalar,
+                           normalizeVectorsScalar, cullSpheresScalar, cullBoxesScalar,
+                           transposeMatrix4x4Scalar, invertMatrix4x4Scalar};
+#ifdef MATH_X86
+  if (level == MATH_KERNELS_SSE)
+    table = (MathKernelTable){MATH_KERNELS_SSE, multiplyMatrices4x4SSE, transformVectors4SSE,
+                              normalizeVectorsSSE, cullSpheresSSE, cullBoxesSSE,
+                              transposeMatrix4x4SSE, invertMatrix4x4SSE};
+  // normalizing packed vec3 and single 4x4 transposes and inverses do not gain from wider
+  // registers, the SSE versions are kept
+  if (level == MATH_KERNELS_AVX)
+    table = (MathKernelTable){MATH_KERNELS_AVX, multiplyMatrices4x4AVX, transformVectors4AVX,
+                              normalizeVectorsSSE, cullSpheresAVX, cullBoxesAVX,
+                              transposeMatrix4x4SSE, invertMatrix4x4SSE};
+#endif
+  kernels = table;
+  return 1;
+}
+
+MathKernels getMathKernels(void)
+{
+  if (!kernels.multiply4x4)
+  {
+    // widest supported set
+    if (!setMathKernels(MATH_KERNELS_AVX) && !setMathKernels(MATH_KERNELS_SSE))
+      setMathKernels(MATH_KERNELS_SCALAR);
+  }
+  return kernels.level;
+}
+
+const char *mathKernelsName(MathKernels level)
+{
+  switch (level)
+  {
+  case MATH_KERNELS_AVX:
+    return "avx";
+  case MATH_KERNELS_SSE:
+    return "sse";
+  default:
+    return "scalar";
+  }
+}
+
+void multiplyMatrices4x4(const float A[16], const float B[16], float result[16])
+{
+  getMathKernels();
+  kernels.multiply4x4(A, B, result);
+}
+void transformVectors4(const float matrix[16], const float *vectors, float *result, int count)
+{
+  getMathKernels();
+  kernels.transform4(matrix, vectors, result, count);
+}
+void normalizeVectors(float *vectors, int count)
+{
+  getMathKernels();
+  kernels.normalize3(vectors, count);
+}
+void transposeMatrix4x4(const float matrix[16], float result[16])
+{
+  getMathKernels();
+  kernels.transpose4x4(matrix, result);
+}
+int invertMatrix4x4(const float matrix[16], float result[16])
+{
+  getMathKernels();
+  return kernels.invert4x4(matrix, result);
+}
+void extractFrustumPlanes(const float m[16], float planes[6][4])
+{
+  // rows of the column-major matrix, a point is inside when row3 +- rowN >= 0 for x, y and z
+  for (int p = 0; p < 6; p++)
+  {
+    int row = p / 2;
+    float sign = (p & 1) ? -1.0f : 1.0f; // left, right, bottom, top, near, far
+    for (int k = 0; k < 4; k++)
+      planes[p][k] = m[k * 4 + 3] + sign * m[k * 4 + row];
+
+    float length = sqrtf(planes[p][0] * planes[p][0] + planes[p][1] * planes[p][1] + planes[p][2] * planes[p][2]);
+    if (length > 0)
+    {
+      for (int k = 0; k < 4; k++)
+        planes[p][k] /= length;
+    }
+  }
+}
+void cullSpheres(const float planes[6][4], const float *spheres, int count, unsigned char *visible)
+{
+  getMathKernels();
+  kernels.cullSpheres(planes, spheres, count, visible);
+}
+void cullBoxes(const float planes[6][4], const float *boxes, int count, unsigned char *visible)
+{
+  getMathKernels();
+  kernels.cullBoxes(planes, boxes, count, visible);
+}
+
 // set uniforms in shader program
 void set_matrix_uniform(GLuint program, const char *uniformName, float *matrix)
 {
@@ -227,6 +752,19 @@ void set_matrix_uniform(GLuint program, const char *uniformName, float *matrix)
   // Set the matrix uniform
   glUniformMatrix4fv(location, 1, GL_FALSE, matrix);
 }
+void set_matrix3_uniform(GLuint program, const char *uniformName, float *matrix)
+{
+  // Get the location of the uniform
+  GLint location = glGetUniformLocation(program, uniformName);
+  if (location == -1)
+  {
+    fprintf(stderr, "Could not find uniform %s\n", uniformName);
+    return;
+  }
+
+  // Set the matrix uniform
+  glUniformMatrix3fv(location, 1, GL_FALSE, matrix);
+}
 void set_int_uniform(GLuint program, const char *uniformName, int value)
 {
   // Get Location
@@ -251,6 +789,18 @@ void set_float_uniform(GLuint program, const char *uniformName, float value)
   // Set Int Unifrom
   glUniform1f(location, value);
 }
+void set_vec2f_uniform(GLuint program, const char *uniformName, float x, float y)
+{
+  // Get Location
+  GLint location = glGetUniformLocation(program, uniformName);
+  if (location == -1)
+  {
+    fprintf(stderr, "Could not find uniform %s\n", uniformName);
+    return;
+  }
+  // Set Vec2 Unifrom
+  glUniform2f(location, x, y);
+}
 void set_vec3f_uniform(GLuint program, const char *uniformName, float x, float y, float z)
 {
   // Get Location
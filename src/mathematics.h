@@ -1,7 +1,11 @@
+#pragma once
+
 #include <glad/glad.h>
 #include <math.h>
 #include <stdio.h>
 
+#include "vecmath.h"
+
 typedef struct
 {
   float position[3];
@@ -24,13 +28,37 @@ void multiplyMatrices4x4(const float A[16], const float B[16], float result[16])
 void addVectors(const float A[3], const float B[3], float result[3]);
 void subtractVectors(const float A[3], const float B[3], float result[3]);
 
+// batched kernels, SSE or AVX picked at runtime from CPU features with a scalar fallback
+typedef enum
+{
+  MATH_KERNELS_SCALAR,
+  MATH_KERNELS_SSE,
+  MATH_KERNELS_AVX
+} MathKernels;
+MathKernels getMathKernels(void);         // selects the widest supported set on first use
+int setMathKernels(MathKernels level);    // returns 0 when the CPU lacks support
+const char *mathKernelsName(MathKernels level);
+void transformVectors4(const float matrix[16], const float *vectors, float *result, int count); // column-major matrix times packed vec4
+void normalizeVectors(float *vectors, int count);                                              // packed vec3
+// planes (a, b, c, d) with normals pointing inwards, for clip space z in [-w, w]
+void extractFrustumPlanes(const float viewProj[16], float planes[6][4]);
+void cullSpheres(const float planes[6][4], const float *spheres, int count, unsigned char *visible); // x, y, z, radius per sphere
+void cullBoxes(const float planes[6][4], const float *boxes, int count, unsigned char *visible);     // min xyz, max xyz per box
+
 // basic matrix functions
 void create_identity_matrix(float *matrix);
 void translateMatrix(float *matrix, float x_translation, float y_translation, float z_translation);
 void scaleMatrix4x4ColumnMajor(float *matrix, float sx, float sy, float sz);
+// these two go through the kernel sets above as well
+void transposeMatrix4x4(const float matrix[16], float result[16]);
+int invertMatrix4x4(const float matrix[16], float result[16]); // returns 0 and leaves result untouched when singular
+// inverse transpose of the upper 3x3 of a column-major model matrix, column-major mat3
+int create_normal_matrix(const float model[16], float normalMatrix[9]);
 
 // perspective matrix
 void create_perspective_matrix(float fov, float aspect, float near, float far, float *matrix);
+// reversed-Z with an infinite far plane, maps near to 1 and infinity to 0 (needs a [0, 1] clip range)
+void create_reversed_perspective_matrix(float fov, float aspect, float near, float *matrix);
 
 // view matrix
 // may need to change these functions
@@ -40,7 +68,9 @@ void updateCameraVectors(Camera *camera);
 
 // set uniforms in shader program
 void set_matrix_uniform(GLuint program, const char *uniformName, float *matrix);
+void set_matrix3_uniform(GLuint program, const char *uniformName, float *matrix);
 void set_int_uniform(GLuint program, const char *uniformName, int value);
 void set_float_uniform(GLuint program, const char *uniformName, float value);
+void set_vec2f_uniform(GLuint program, const char *uniformName, float x, float y);
 void set_vec3f_uniform(GLuint program, const char *uniformName, float x, float y, float z);
 void set_vec3fv_uniform(GLuint program, const char *uniformName, const float vector3[3]);
\ No newline at end of file
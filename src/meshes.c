@@ -1,6 +1,105 @@
 #include "meshes.h"
 
+#include <pthread.h>
+#include <stddef.h>
+#include <string.h>
+#include <unistd.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// a vertex is written as two 4-float halves
+_Static_assert(sizeof(Vertex) == 8 * sizeof(float), "Vertex must be 8 packed floats");
+
+// one worker's share of the sphere, whole stacks so rows never overlap
+typedef struct
+{
+  const float *sliceTable; // per slice {cos, sin, 0, cos, sin, 0, u, 0}
+  float radius;
+  int stacks, slices;
+  int firstStack, lastStack; // vertex rows [firstStack, lastStack), quads start in the same rows
+  Vertex *vertices;
+  unsigned int *indices;
+} SphereJob;
+
+static void generateSphereRows(const SphereJob *job)
+{
+  int stacks = job->stacks;
+  int slices = job->slices;
+  float radius = job->radius;
+
+  for (int i = job->firstStack; i < job->lastStack; ++i)
+  {
+    float stackAngle = M_PI / 2 - i * M_PI / stacks; // angle from top to bottom
+    float ring = cosf(stackAngle);                   // radius of the current stack on the unit sphere
+    float z = sinf(stackAngle);                      // z position of the current stack
+
+    // the unit direction is the normal, scaling it gives the position:
+    // first half  {cos, sin, 0, cos} * {r ring, r ring, 0, ring} + {0, 0, r z, 0} = position, normal.x
+    // second half {sin, 0, u, 0} * {ring, 0, 1, 0} + {0, z, 0, v} = normal.yz, texCoord
+    const float scale[8] = {radius * ring, radius * ring, 0.0f, ring, ring, 0.0f, 1.0f, 0.0f};
+    const float offset[8] = {0.0f, 0.0f, radius * z, 0.0f, 0.0f, z, 0.0f, (float)i / stacks};
+    const float *table = job->sliceTable;
+    float *out = (float *)(job->vertices + i * (slices + 1));
+
+#ifdef __SSE2__
+    __m128 scale0 = _mm_loadu_ps(scale), scale1 = _mm_loadu_ps(scale + 4);
+    __m128 offset0 = _mm_loadu_ps(offset), offset1 = _mm_loadu_ps(offset + 4);
+    for (int j = 0; j <= slices; ++j, table += 8, out += 8)
+    {
+      _mm_storeu_ps(out, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(table), scale0), offset0));
+      _mm_storeu_ps(out + 4, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(table + 4), scale1), offset1));
+    }
+#else
+    for (int j = 0; j <= slices; ++j, table += 8, out += 8)
+    {
+      for (int k = 0; k < 8; k++)
+        out[k] = table[k] * scale[k] + offset[k];
+    }
+#endif
+  }
+
+  // two triangles per quad between this row and the next
+  int lastQuadRow = job->lastStack < stacks ? job->lastStack : stacks;
+  unsigned int *indices = job->indices + (size_t)job->firstStack * slices * 6;
+  for (int i = job->firstStack; i < lastQuadRow; ++i)
+  {
+    for (int j = 0; j < slices; ++j)
+    {
+      unsigned int first = i * (slices + 1) + j;
+      unsigned int second = first + slices + 1;
+
+      // First triangle of the quad
+      *indices++ = first;
+      *indices++ = second;
+      *indices++ = first + 1;
+
+      // Second triangle of the quad
+      *indices++ = second;
+      *indices++ = second + 1;
+      *indices++ = first + 1;
+    }
+  }
+}
+
+static void *sphereWorker(void *job)
+{
+  generateSphereRows(job);
+  return NULL;
+}
+
+static int sphereThreadCount(int vertexCount, int stacks)
+{
+  if (vertexCount < SPHERE_THREAD_MIN_VERTICES)
+    return 1;
+  long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  int threads = cpus < 1 ? 1 : (cpus > SPHERE_MAX_THREADS ? SPHERE_MAX_THREADS : (int)cpus);
+  return threads > stacks + 1 ? stacks + 1 : threads;
+}
+
 // Function to generate a sphere mesh
+// Trigonometry is done once per stack and per slice, vertices are written with SSE and large
+// meshes are split across threads by stack range.
 void generateSphereMesh(float radius, int stacks, int slices, Vertex **outVertices, unsigned int **outIndices, int *outVertexCount, int *outIndexCount)
 {
   int vertexCount = (stacks + 1) * (slices + 1);
@@ -9,68 +108,292 @@ void generateSphereMesh(float radius, int stacks, int slices, Vertex **outVertic
   // Allocate memory for vertices and indices
   *outVertices = (Vertex *)malloc(vertexCount * sizeof(Vertex));
   *outIndices = (unsigned int *)malloc(indexCount * sizeof(unsigned int));
+  float *sliceTable = (float *)malloc((slices + 1) * 8 * sizeof(float));
+  if (!*outVertices || !*outIndices || !sliceTable)
+  {
+    fprintf(stderr, "Failed to allocate a %dx%d sphere mesh\n", stacks, slices);
+    free(*outVertices);
+    free(*outIndices);
+    free(sliceTable);
+    *outVertices = NULL;
+    *outIndices = NULL;
+    *outVertexCount = 0;
+    *outIndexCount = 0;
+    return;
+  }
 
-  Vertex *vertices = *outVertices;
-  unsigned int *indices = *outIndices;
+  for (int j = 0; j <= slices; ++j)
+  {
+    float sliceAngle = j * 2 * M_PI / slices; // angle around the sphere
+    float c = cosf(sliceAngle), s = sinf(sliceAngle);
+    float *entry = sliceTable + j * 8;
+    entry[0] = c;
+    entry[1] = s;
+    entry[2] = 0.0f;
+    entry[3] = c;
+    entry[4] = s;
+    entry[5] = 0.0f;
+    entry[6] = (float)j / slices;
+    entry[7] = 0.0f;
+  }
 
-  int vertexIndex = 0;
-  int indexIndex = 0;
+  // the rows are split evenly, the caller generates the first share itself
+  SphereJob jobs[SPHERE_MAX_THREADS];
+  pthread_t threads[SPHERE_MAX_THREADS];
+  int started[SPHERE_MAX_THREADS] = {0};
+  int threadCount = sphereThreadCount(vertexCount, stacks);
+  for (int t = 0; t < threadCount; t++)
+  {
+    jobs[t] = (SphereJob){sliceTable, radius, stacks, slices, (stacks + 1) * t / threadCount,
+                          (stacks + 1) * (t + 1) / threadCount, *outVertices, *outIndices};
+    if (t > 0)
+      started[t] = pthread_create(&threads[t], NULL, sphereWorker, &jobs[t]) == 0;
+  }
+  generateSphereRows(&jobs[0]);
+  for (int t = 1; t < threadCount; t++)
+  {
+    if (started[t])
+      pthread_join(threads[t], NULL);
+    else
+      generateSphereRows(&jobs[t]);
+  }
+  free(sliceTable);
 
-  // Generate vertices
-  for (int i = 0; i <= stacks; ++i)
+  *outVertexCount = vertexCount;
+  *outIndexCount = indexCount;
+}
+
+// One strip per stack zig-zagging between its upper and lower row, 2 * (slices + 1) indices each
+// with MESH_RESTART_INDEX between stacks, instead of 6 indices per quad.
+int generateSphereStripIndices(int stacks, int slices, unsigned int **outIndices, int *outIndexCount)
+{
+  int indexCount = stacks * (2 * (slices + 1) + 1) - 1;
+  unsigned int *indices = malloc((size_t)indexCount * sizeof(unsigned int));
+  *outIndices = indices;
+  *outIndexCount = indices ? indexCount : 0;
+  if (!indices)
   {
-    float stackAngle = M_PI / 2 - i * M_PI / stacks; // angle from top to bottom
-    float xy = radius * cosf(stackAngle);            // radius of the current stack
-    float z = radius * sinf(stackAngle);             // z position of the current stack
+    fprintf(stderr, "Failed to allocate strips for a %dx%d sphere\n", stacks, slices);
+    return 0;
+  }
 
+  for (int i = 0; i < stacks; ++i)
+  {
+    if (i > 0)
+      *indices++ = MESH_RESTART_INDEX;
+    // first, second, first + 1 is the first triangle of the quad list, the strip's odd triangles
+    // are flipped by GL and come out as second, second + 1, first + 1
     for (int j = 0; j <= slices; ++j)
     {
-      float sliceAngle = j * 2 * M_PI / slices; // angle around the sphere
+      unsigned int first = i * (slices + 1) + j;
+      *indices++ = first;
+      *indices++ = first + slices + 1;
+    }
+  }
+  return 1;
+}
 
-      float x = xy * cosf(sliceAngle);
-      float y = xy * sinf(sliceAngle);
+// allocates a generator's output, on failure everything is released and zeroed
+static int allocateMesh(const char *name, int vertexCount, int indexCount, Vertex **outVertices, unsigned int **outIndices, int *outVertexCount, int *outIndexCount)
+{
+  *outVertices = (Vertex *)malloc((size_t)vertexCount * sizeof(Vertex));
+  *outIndices = (unsigned int *)malloc((size_t)indexCount * sizeof(unsigned int));
+  *outVertexCount = vertexCount;
+  *outIndexCount = indexCount;
+  if (*outVertices && *outIndices)
+    return 1;
 
-      // Position
-      vertices[vertexIndex].position[0] = x;
-      vertices[vertexIndex].position[1] = y;
-      vertices[vertexIndex].position[2] = z;
+  fprintf(stderr, "Failed to allocate a %s mesh of %d vertices\n", name, vertexCount);
+  free(*outVertices);
+  free(*outIndices);
+  *outVertices = NULL;
+  *outIndices = NULL;
+  *outVertexCount = 0;
+  *outIndexCount = 0;
+  return 0;
+}
 
-      // Normal
-      float length = sqrtf(x * x + y * y + z * z);
-      vertices[vertexIndex].normal[0] = x / length;
-      vertices[vertexIndex].normal[1] = y / length;
-      vertices[vertexIndex].normal[2] = z / length;
+// direction on the unit sphere to a vertex with the same texture mapping as generateSphereMesh
+static void setSphereVertex(Vertex *vertex, vec3 direction, float radius)
+{
+  vec3 normal = vec3_normalize(direction);
+  vec3_store(vec3_scale(normal, radius), vertex->position);
+  vec3_store(normal, vertex->normal);
+  float u = atan2f(normal.y, normal.x) / (2.0f * M_PI);
+  vertex->texCoord[0] = u < 0.0f ? u + 1.0f : u;
+  vertex->texCoord[1] = acosf(fmaxf(-1.0f, fminf(1.0f, normal.z))) / M_PI;
+}
 
-      // Texture coordinates
-      vertices[vertexIndex].texCoord[0] = (float)j / slices;
-      vertices[vertexIndex].texCoord[1] = (float)i / stacks;
+// Each icosahedron face is split into a triangular grid with 2^subdivisions segments per edge and
+// projected onto the sphere. Corners come first, then the segment points of every edge in the
+// order the edges are first met, then each face's interior, so a face finds shared vertices from
+// its edge numbers instead of looking positions up in a hash table.
+void generateIcosphereMesh(float radius, int subdivisions, Vertex **outVertices, unsigned int **outIndices, int *outVertexCount, int *outIndexCount)
+{
+  static const float t = 1.6180339887f; // golden ratio
+  static const float corners[12][3] = {{-1, t, 0}, {1, t, 0}, {-1, -t, 0}, {1, -t, 0}, {0, -1, t}, {0, 1, t},
+                                       {0, -1, -t}, {0, 1, -t}, {t, 0, -1}, {t, 0, 1}, {-t, 0, -1}, {-t, 0, 1}};
+  // counter-clockwise seen from outside like generateSphereMesh
+  static const int faces[20][3] = {{0, 11, 5}, {0, 5, 1}, {0, 1, 7}, {0, 7, 10}, {0, 10, 11}, {1, 5, 9}, {5, 11, 4},
+                                   {11, 10, 2}, {10, 7, 6}, {7, 1, 8}, {3, 9, 4}, {3, 4, 2}, {3, 2, 6}, {3, 6, 8},
+                                   {3, 8, 9}, {4, 9, 5}, {2, 4, 11}, {6, 2, 10}, {8, 6, 7}, {9, 8, 1}};
 
-      vertexIndex++;
-    }
+  if (subdivisions < 0)
+    subdivisions = 0;
+  int segments = 1 << subdivisions;
+  int edgePoints = segments - 1;
+  int facePoints = (segments - 1) * (segments - 2) / 2;
+  int vertexCount = 12 + 30 * edgePoints + 20 * facePoints;
+  int indexCount = 20 * segments * segments * 3;
+  // grid of one face, (i, j) steps along its first and second edge
+  int *grid = malloc((size_t)(segments + 1) * (segments + 2) / 2 * sizeof(int));
+  if (!grid || !allocateMesh("icosphere", vertexCount, indexCount, outVertices, outIndices, outVertexCount, outIndexCount))
+  {
+    free(grid);
+    return;
   }
+  Vertex *vertices = *outVertices;
+  unsigned int *indices = *outIndices;
 
-  // Generate indices
-  for (int i = 0; i < stacks; ++i)
+  for (int c = 0; c < 12; c++)
+    setSphereVertex(&vertices[c], vec3_load(corners[c]), radius);
+
+  int edges[30][2];
+  int edgeCount = 0;
+  int nextVertex = 12 + 30 * edgePoints;
+  int indexIndex = 0;
+#define GRID(i, j) grid[(i) * (2 * segments + 3 - (i)) / 2 + (j)]
+
+  for (int f = 0; f < 20; f++)
   {
-    for (int j = 0; j < slices; ++j)
+    const int *face = faces[f];
+    vec3 a = vec3_load(corners[face[0]]);
+    vec3 ab = vec3_scale(vec3_sub(vec3_load(corners[face[1]]), a), 1.0f / segments);
+    vec3 ac = vec3_scale(vec3_sub(vec3_load(corners[face[2]]), a), 1.0f / segments);
+
+    // the three edges as (i, j) start and step: a to b, a to c, b to c
+    const int edgeEnds[3][2] = {{face[0], face[1]}, {face[0], face[2]}, {face[1], face[2]}};
+    const int edgeStart[3][2] = {{0, 0}, {0, 0}, {segments, 0}};
+    const int edgeStep[3][2] = {{1, 0}, {0, 1}, {-1, 1}};
+    for (int e = 0; e < 3; e++)
     {
-      int first = i * (slices + 1) + j;
-      int second = first + slices + 1;
+      int from = edgeEnds[e][0], to = edgeEnds[e][1];
+      int edge = 0;
+      while (edge < edgeCount && !(edges[edge][0] == from && edges[edge][1] == to) && !(edges[edge][0] == to && edges[edge][1] == from))
+        edge++;
+      int reversed = edge < edgeCount && edges[edge][0] == to;
+      if (edge == edgeCount)
+      {
+        // first face to use the edge creates its points
+        edges[edgeCount][0] = from;
+        edges[edgeCount][1] = to;
+        edgeCount++;
+        vec3 start = vec3_load(corners[from]);
+        vec3 step = vec3_scale(vec3_sub(vec3_load(corners[to]), start), 1.0f / segments);
+        for (int k = 1; k < segments; k++)
+          setSphereVertex(&vertices[12 + edge * edgePoints + k - 1], vec3_add(start, vec3_scale(step, (float)k)), radius);
+      }
+      for (int k = 1; k < segments; k++)
+      {
+        int point = reversed ? segments - k : k;
+        GRID(edgeStart[e][0] + edgeStep[e][0] * k, edgeStart[e][1] + edgeStep[e][1] * k) = 12 + edge * edgePoints + point - 1;
+      }
+    }
+    GRID(0, 0) = face[0];
+    GRID(segments, 0) = face[1];
+    GRID(0, segments) = face[2];
 
-      // First triangle of the quad
-      indices[indexIndex++] = first;
-      indices[indexIndex++] = second;
-      indices[indexIndex++] = first + 1;
+    for (int i = 1; i < segments; i++)
+    {
+      for (int j = 1; i + j < segments; j++)
+      {
+        setSphereVertex(&vertices[nextVertex], vec3_add(a, vec3_add(vec3_scale(ab, (float)i), vec3_scale(ac, (float)j))), radius);
+        GRID(i, j) = nextVertex++;
+      }
+    }
 
-      // Second triangle of the quad
-      indices[indexIndex++] = second;
-      indices[indexIndex++] = second + 1;
-      indices[indexIndex++] = first + 1;
+    // keeps the face's winding
+    for (int i = 0; i < segments; i++)
+    {
+      for (int j = 0; i + j < segments; j++)
+      {
+        indices[indexIndex++] = GRID(i, j);
+        indices[indexIndex++] = GRID(i + 1, j);
+        indices[indexIndex++] = GRID(i, j + 1);
+        if (i + j < segments - 1)
+        {
+          indices[indexIndex++] = GRID(i + 1, j);
+          indices[indexIndex++] = GRID(i + 1, j + 1);
+          indices[indexIndex++] = GRID(i, j + 1);
+        }
+      }
     }
   }
+#undef GRID
+  free(grid);
+}
 
-  *outVertexCount = vertexCount;
-  *outIndexCount = indexCount;
+// A (resolution x resolution) grid on each cube face mapped onto the sphere with the spherified
+// cube formula, which spreads the vertices far more evenly than normalizing the cube point. Face
+// borders are duplicated since every face has its own texture coordinates, so each grid point is
+// addressed by (face, row, column) directly.
+void generateCubeSphereMesh(float radius, int resolution, Vertex **outVertices, unsigned int **outIndices, int *outVertexCount, int *outIndexCount)
+{
+  // outward normal, then u and v with u x v = normal so quads wind like generateSphereMesh
+  static const float axes[6][3][3] = {
+      {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}},  {{-1, 0, 0}, {0, 0, 1}, {0, 1, 0}}, {{0, 1, 0}, {0, 0, 1}, {1, 0, 0}},
+      {{0, -1, 0}, {1, 0, 0}, {0, 0, 1}}, {{0, 0, 1}, {1, 0, 0}, {0, 1, 0}},  {{0, 0, -1}, {0, 1, 0}, {1, 0, 0}}};
+
+  if (resolution < 1)
+    resolution = 1;
+  int row = resolution + 1;
+  int vertexCount = 6 * row * row;
+  int indexCount = 6 * resolution * resolution * 6;
+  if (!allocateMesh("cube sphere", vertexCount, indexCount, outVertices, outIndices, outVertexCount, outIndexCount))
+    return;
+  Vertex *vertices = *outVertices;
+  unsigned int *indices = *outIndices;
+
+  int indexIndex = 0;
+  for (int f = 0; f < 6; f++)
+  {
+    vec3 normal = vec3_load(axes[f][0]), u = vec3_load(axes[f][1]), v = vec3_load(axes[f][2]);
+    Vertex *faceVertices = vertices + f * row * row;
+    for (int t = 0; t <= resolution; t++)
+    {
+      for (int s = 0; s <= resolution; s++)
+      {
+        vec3 p = vec3_add(normal, vec3_add(vec3_scale(u, 2.0f * s / resolution - 1.0f), vec3_scale(v, 2.0f * t / resolution - 1.0f)));
+        float x2 = p.x * p.x, y2 = p.y * p.y, z2 = p.z * p.z;
+        vec3 direction = vec3_make(p.x * sqrtf(1.0f - y2 / 2.0f - z2 / 2.0f + y2 * z2 / 3.0f),
+                                   p.y * sqrtf(1.0f - z2 / 2.0f - x2 / 2.0f + z2 * x2 / 3.0f),
+                                   p.z * sqrtf(1.0f - x2 / 2.0f - y2 / 2.0f + x2 * y2 / 3.0f));
+
+        Vertex *vertex = &faceVertices[t * row + s];
+        vec3 unit = vec3_normalize(direction);
+        vec3_store(vec3_scale(unit, radius), vertex->position);
+        vec3_store(unit, vertex->normal);
+        vertex->texCoord[0] = (float)s / resolution;
+        vertex->texCoord[1] = (float)t / resolution;
+      }
+    }
+
+    unsigned int base = f * row * row;
+    for (int t = 0; t < resolution; t++)
+    {
+      for (int s = 0; s < resolution; s++)
+      {
+        unsigned int first = base + t * row + s;
+        unsigned int above = first + row;
+        indices[indexIndex++] = first;
+        indices[indexIndex++] = first + 1;
+        indices[indexIndex++] = above;
+        indices[indexIndex++] = first + 1;
+        indices[indexIndex++] = above + 1;
+        indices[indexIndex++] = above;
+      }
+    }
+  }
 }
 
 void setupSphereMesh(float radius, int stacks, int slices, unsigned int *vao, unsigned int *vbo, unsigned int *ebo, int *indexCountReturn)
@@ -82,9 +405,20 @@ void setupSphereMesh(float radius, int stacks, int slices, unsigned int *vao, un
   // Generate the sphere mesh
   generateSphereMesh(radius, stacks, slices, &vertices, &indices, &vertexCount, &indexCount);
 
-  glGenVertexArrays(1, &*vao);
-  glGenBuffers(1, &*vbo);
-  glGenBuffers(1, &*ebo);
+  uploadMesh(vertices, vertexCount, indices, indexCount, vao, vbo, ebo);
+
+  // Free the mesh data (now stored in OpenGL buffers)
+  free(vertices);
+  free(indices);
+  *indexCountReturn = indexCount;
+}
+
+// creates a VAO with position, normal and texture coordinate attributes 0, 1 and 2
+void uploadMesh(const Vertex *vertices, int vertexCount, const unsigned int *indices, int indexCount, unsigned int *vao, unsigned int *vbo, unsigned int *ebo)
+{
+  glGenVertexArrays(1, vao);
+  glGenBuffers(1, vbo);
+  glGenBuffers(1, ebo);
 
   glBindVertexArray(*vao);
 
@@ -109,11 +443,6 @@ void setupSphereMesh(float radius, int stacks, int slices, unsigned int *vao, un
   glEnableVertexAttribArray(2);
 
   glBindVertexArray(0);
-
-  // Free the mesh data (now stored in OpenGL buffers)
-  free(vertices);
-  free(indices);
-  *indexCountReturn = indexCount;
 }
 
 void renderSphereMesh(unsigned int vao, int indexCount)
@@ -121,4 +450,274 @@ void renderSphereMesh(unsigned int vao, int indexCount)
   glBindVertexArray(vao);
   glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0);
   glBindVertexArray(0);
-}
\ No newline at end of file
+}
+uint16_t floatToHalf(float value)
+{
+  union
+  {
+    float f;
+    uint32_t u;
+  } bits = {value};
+  uint32_t sign = (bits.u >> 16) & 0x8000;
+  int exponent = (int)((bits.u >> 23) & 0xff) - 127 + 15;
+  uint32_t mantissa = bits.u & 0x7fffff;
+
+  if (exponent >= 31)
+    return sign | 0x7c00; // overflow and infinity, texture coordinates never get here
+  if (exponent <= 0)
+  {
+    if (exponent < -10)
+      return sign;
+    // denormal, shift in the implicit bit
+    mantissa |= 0x800000;
+    return sign | ((mantissa >> (14 - exponent)) + ((mantissa >> (13 - exponent)) & 1));
+  }
+  // rounding may carry into the exponent, which is still the correct result
+  return (sign | (exponent << 10) | (mantissa >> 13)) + ((mantissa >> 12) & 1);
+}
+
+static int16_t toSnorm16(float value)
+{
+  value = value < -1.0f ? -1.0f : (value > 1.0f ? 1.0f : value);
+  return (int16_t)lrintf(value * 32767.0f);
+}
+
+// unit vector onto the octahedron |x| + |y| + |z| = 1, the lower half folded over the upper
+void encodeOctahedral(const float normal[3], int16_t encoded[2])
+{
+  float sum = fabsf(normal[0]) + fabsf(normal[1]) + fabsf(normal[2]);
+  float x = normal[0] / sum, y = normal[1] / sum;
+  if (normal[2] < 0.0f)
+  {
+    float foldedX = (1.0f - fabsf(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+    float foldedY = (1.0f - fabsf(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+    x = foldedX;
+    y = foldedY;
+  }
+  encoded[0] = toSnorm16(x);
+  encoded[1] = toSnorm16(y);
+}
+
+int vertexLayoutSize(VertexLayout layout)
+{
+  switch (layout)
+  {
+  case VERTEX_LAYOUT_SPHERE:
+    return sizeof(SphereVertex);
+  case VERTEX_LAYOUT_OCTAHEDRAL:
+    return sizeof(OctahedralVertex);
+  default:
+    return sizeof(Vertex);
+  }
+}
+
+const char *vertexLayoutName(VertexLayout layout)
+{
+  switch (layout)
+  {
+  case VERTEX_LAYOUT_SPHERE:
+    return "sphere";
+  case VERTEX_LAYOUT_OCTAHEDRAL:
+    return "octahedral";
+  default:
+    return "full";
+  }
+}
+
+const void *packVertices(const Vertex *vertices, int vertexCount, VertexLayout layout, void **packed)
+{
+  *packed = NULL;
+  if (layout == VERTEX_LAYOUT_FULL)
+    return vertices;
+
+  *packed = malloc((size_t)vertexCount * vertexLayoutSize(layout));
+  if (!*packed)
+    return NULL;
+
+  for (int i = 0; i < vertexCount; i++)
+  {
+    const Vertex *vertex = &vertices[i];
+    if (layout == VERTEX_LAYOUT_SPHERE)
+    {
+      SphereVertex *out = (SphereVertex *)*packed + i;
+      memcpy(out->position, vertex->position, sizeof(out->position));
+      out->texCoord[0] = floatToHalf(vertex->texCoord[0]);
+      out->texCoord[1] = floatToHalf(vertex->texCoord[1]);
+    }
+    else
+    {
+      OctahedralVertex *out = (OctahedralVertex *)*packed + i;
+      memcpy(out->position, vertex->position, sizeof(out->position));
+      encodeOctahedral(vertex->normal, out->normal);
+      out->texCoord[0] = floatToHalf(vertex->texCoord[0]);
+      out->texCoord[1] = floatToHalf(vertex->texCoord[1]);
+    }
+  }
+  return *packed;
+}
+
+uint16_t *packShortIndices(const unsigned int *indices, int indexCount)
+{
+  uint16_t *packed = malloc((size_t)indexCount * sizeof(uint16_t));
+  for (int i = 0; packed && i < indexCount; i++)
+    packed[i] = indices[i] == MESH_RESTART_INDEX ? 0xffff : (uint16_t)indices[i];
+  return packed;
+}
+
+void setupVertexAttributes(VertexLayout layout)
+{
+  int stride = vertexLayoutSize(layout);
+
+  // Position attribute
+  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void *)0);
+  glEnableVertexAttribArray(0);
+  switch (layout)
+  {
+  case VERTEX_LAYOUT_FULL:
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void *)offsetof(Vertex, normal));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void *)offsetof(Vertex, texCoord));
+    glEnableVertexAttribArray(2);
+    break;
+  case VERTEX_LAYOUT_SPHERE:
+    glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, stride, (void *)offsetof(SphereVertex, texCoord));
+    glEnableVertexAttribArray(2);
+    break;
+  default:
+    glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, stride, (void *)offsetof(OctahedralVertex, normal));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, stride, (void *)offsetof(OctahedralVertex, texCoord));
+    glEnableVertexAttribArray(2);
+    break;
+  }
+}
+
+int uploadMeshLayout(const Vertex *vertices, int vertexCount, const unsigned int *indices, int indexCount, GLenum primitive, VertexLayout layout, Mesh *mesh)
+{
+  memset(mesh, 0, sizeof(*mesh));
+
+  void *packedVertices;
+  const void *vertexData = packVertices(vertices, vertexCount, layout, &packedVertices);
+  int shortIndices = vertexCount <= MESH_MAX_SHORT_VERTICES;
+  int indexSize = shortIndices ? sizeof(uint16_t) : sizeof(unsigned int);
+  uint16_t *packedIndices = shortIndices ? packShortIndices(indices, indexCount) : NULL;
+  if (!vertexData || (shortIndices && !packedIndices))
+  {
+    fprintf(stderr, "Failed to allocate a packed mesh of %d vertices\n", vertexCount);
+    free(packedVertices);
+    free(packedIndices);
+    return 0;
+  }
+
+  int stride = vertexLayoutSize(layout);
+  glGenVertexArrays(1, &mesh->vao);
+  glGenBuffers(1, &mesh->vbo);
+  glGenBuffers(1, &mesh->ebo);
+  glBindVertexArray(mesh->vao);
+
+  glBindBuffer(GL_ARRAY_BUFFER, mesh->vbo);
+  glBufferData(GL_ARRAY_BUFFER, (size_t)vertexCount * stride, vertexData, GL_STATIC_DRAW);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->ebo);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, (size_t)indexCount * indexSize, shortIndices ? (const void *)packedIndices : indices, GL_STATIC_DRAW);
+  setupVertexAttributes(layout);
+  glBindVertexArray(0);
+
+  free(packedVertices);
+  free(packedIndices);
+  mesh->indexCount = indexCount;
+  mesh->indexType = shortIndices ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+  mesh->primitive = primitive;
+  mesh->layout = layout;
+  mesh->bytes = (size_t)vertexCount * stride + (size_t)indexCount * indexSize;
+  return 1;
+}
+
+int setupSphereMeshLayout(float radius, int stacks, int slices, VertexLayout layout, Mesh *mesh)
+{
+  Vertex *vertices;
+  unsigned int *indices;
+  int vertexCount, indexCount;
+  generateSphereMesh(radius, stacks, slices, &vertices, &indices, &vertexCount, &indexCount);
+  if (!vertices)
+  {
+    memset(mesh, 0, sizeof(*mesh));
+    return 0;
+  }
+
+  int result = uploadMeshLayout(vertices, vertexCount, indices, indexCount, GL_TRIANGLES, layout, mesh);
+  free(vertices);
+  free(indices);
+  return result;
+}
+
+// the restart index is the largest value of the index type either way
+void enablePrimitiveRestart(GLenum indexType)
+{
+  if (GLAD_GL_VERSION_4_3)
+    glEnable(GL_PRIMITIVE_RESTART_FIXED_INDEX);
+  else
+  {
+    glEnable(GL_PRIMITIVE_RESTART);
+    glPrimitiveRestartIndex(indexType == GL_UNSIGNED_SHORT ? 0xffff : MESH_RESTART_INDEX);
+  }
+}
+void disablePrimitiveRestart(void)
+{
+  glDisable(GLAD_GL_VERSION_4_3 ? GL_PRIMITIVE_RESTART_FIXED_INDEX : GL_PRIMITIVE_RESTART);
+}
+
+void renderMesh(const Mesh *mesh)
+{
+  glBindVertexArray(mesh->vao);
+  drawMesh(mesh);
+  glBindVertexArray(0);
+}
+
+void drawMesh(const Mesh *mesh)
+{
+  if (mesh->primitive == GL_TRIANGLE_STRIP)
+    enablePrimitiveRestart(mesh->indexType);
+  glDrawElementsBaseVertex(mesh->primitive, mesh->indexCount, mesh->indexType, (void *)mesh->indexOffset, mesh->baseVertex);
+  if (mesh->primitive == GL_TRIANGLE_STRIP)
+    disablePrimitiveRestart();
+}
+
+void renderMeshPatches(const Mesh *mesh)
+{
+  glBindVertexArray(mesh->vao);
+  glPatchParameteri(GL_PATCH_VERTICES, 3);
+  glDrawElementsBaseVertex(GL_PATCHES, mesh->indexCount, mesh->indexType, (void *)mesh->indexOffset, mesh->baseVertex);
+  glBindVertexArray(0);
+}
+
+void destroyMesh(Mesh *mesh)
+{
+  glDeleteVertexArrays(1, &mesh->vao);
+  glDeleteBuffers(1, &mesh->vbo);
+  glDeleteBuffers(1, &mesh->ebo);
+  memset(mesh, 0, sizeof(*mesh));
+}
+
+// drawing needs a bound VAO even when no attribute is read
+static unsigned int proceduralVao;
+
+void renderProceduralSphere(int stacks, int slices, float radius)
+{
+  GLint program;
+  glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+  glUniform1i(glGetUniformLocation(program, "sphereStacks"), stacks);
+  glUniform1i(glGetUniformLocation(program, "sphereSlices"), slices);
+  glUniform1f(glGetUniformLocation(program, "sphereRadius"), radius);
+
+  if (!proceduralVao)
+    glGenVertexArrays(1, &proceduralVao);
+  glBindVertexArray(proceduralVao);
+  glDrawArrays(GL_TRIANGLES, 0, stacks * slices * 6);
+  glBindVertexArray(0);
+}
+
+void releaseProceduralSphere(void)
+{
+  glDeleteVertexArrays(1, &proceduralVao);
+  proceduralVao = 0;
+}
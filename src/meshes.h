@@ -1,7 +1,17 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
 #include <glad/glad.h>
 
+#include "vecmath.h"
+
+// sphere generation runs on several threads above this many vertices, up to SPHERE_MAX_THREADS
+#define SPHERE_THREAD_MIN_VERTICES 65536
+#define SPHERE_MAX_THREADS 16
+
 // Vertex structure
 typedef struct
 {
@@ -10,9 +20,89 @@ typedef struct
   float texCoord[2];
 } Vertex;
 
+// separates triangle strips in index arrays, written as the largest value of the uploaded index type
+#define MESH_RESTART_INDEX 0xffffffffu
+#define MESH_MAX_SHORT_VERTICES 0xffff // 16-bit indices up to here, 0xffff itself is the restart index
+
+// GPU vertex formats, all keep the position in attribute 0
+typedef enum
+{
+  VERTEX_LAYOUT_FULL,       // Vertex as generated, 32 bytes
+  VERTEX_LAYOUT_SPHERE,     // position and half float texCoord, 16 bytes, the shader uses the position as normal
+  VERTEX_LAYOUT_OCTAHEDRAL, // adds an octahedral snorm16 normal for meshes that are not spheres, 20 bytes
+  VERTEX_LAYOUT_COUNT
+} VertexLayout;
+
+typedef struct
+{
+  float position[3];
+  uint16_t texCoord[2]; // half floats
+} SphereVertex;
+
+typedef struct
+{
+  float position[3];
+  int16_t normal[2]; // octahedral
+  uint16_t texCoord[2];
+} OctahedralVertex;
+
+// an uploaded mesh and how to draw it
+typedef struct
+{
+  unsigned int vao, vbo, ebo;
+  int indexCount;
+  GLenum indexType; // GL_UNSIGNED_SHORT whenever every index fits
+  GLenum primitive; // GL_TRIANGLES or GL_TRIANGLE_STRIP with MESH_RESTART_INDEX between strips
+  int baseVertex;     // where the mesh starts in shared buffers, 0 when it has its own
+  size_t indexOffset; // bytes
+  VertexLayout layout;
+  size_t bytes; // vertex and index buffer memory
+} Mesh;
+
 // Function to generate a sphere mesh
 void generateSphereMesh(float radius, int stacks, int slices, Vertex **outVertices, unsigned int **outIndices, int *outVertexCount, int *outIndexCount);
 
+// same output as generateSphereMesh with evenly sized triangles instead of crowded poles:
+// an icosahedron with every edge split into 2^subdivisions segments (20 * 4^subdivisions triangles)
+void generateIcosphereMesh(float radius, int subdivisions, Vertex **outVertices, unsigned int **outIndices, int *outVertexCount, int *outIndexCount);
+// a spherified cube with resolution x resolution quads per face (12 * resolution^2 triangles)
+void generateCubeSphereMesh(float radius, int resolution, Vertex **outVertices, unsigned int **outIndices, int *outVertexCount, int *outIndexCount);
+
+// triangle strip indices for generateSphereMesh's vertices, about a third of the list's size
+int generateSphereStripIndices(int stacks, int slices, unsigned int **outIndices, int *outIndexCount);
+
 void setupSphereMesh(float radius, int stacks, int slices, unsigned int *vao, unsigned int *vbo, unsigned int *ebo, int *indexCountReturn);
 
-void renderSphereMesh(unsigned int vao, int indexCount);
\ No newline at end of file
+// creates a VAO with position, normal and texture coordinate attributes 0, 1 and 2
+void uploadMesh(const Vertex *vertices, int vertexCount, const unsigned int *indices, int indexCount, unsigned int *vao, unsigned int *vbo, unsigned int *ebo);
+
+void renderSphereMesh(unsigned int vao, int indexCount);
+
+// packs vertices into the layout (attribute 1 is the normal, 2 the texCoord where present) and
+// picks 16-bit indices when the mesh has at most MESH_MAX_SHORT_VERTICES vertices
+int uploadMeshLayout(const Vertex *vertices, int vertexCount, const unsigned int *indices, int indexCount, GLenum primitive, VertexLayout layout, Mesh *mesh);
+int setupSphereMeshLayout(float radius, int stacks, int slices, VertexLayout layout, Mesh *mesh);
+void renderMesh(const Mesh *mesh);
+// draws with whatever VAO is bound, for meshes sharing one
+void drawMesh(const Mesh *mesh);
+// draws a triangle list mesh as GL_PATCHES of 3 control points for a tessellation shader
+void renderMeshPatches(const Mesh *mesh);
+void destroyMesh(Mesh *mesh);
+
+// building blocks of uploadMeshLayout
+// vertices converted to the layout, Vertex itself is returned for VERTEX_LAYOUT_FULL, free *packed afterwards
+const void *packVertices(const Vertex *vertices, int vertexCount, VertexLayout layout, void **packed);
+uint16_t *packShortIndices(const unsigned int *indices, int indexCount);
+// attribute pointers of the layout into the bound GL_ARRAY_BUFFER
+void setupVertexAttributes(VertexLayout layout);
+void enablePrimitiveRestart(GLenum indexType);
+void disablePrimitiveRestart(void);
+
+int vertexLayoutSize(VertexLayout layout);
+const char *vertexLayoutName(VertexLayout layout);
+uint16_t floatToHalf(float value);
+void encodeOctahedral(const float normal[3], int16_t encoded[2]);
+// draws the triangles of generateSphereMesh without any vertex data, the bound program must be
+// compiled with PROCEDURAL_SPHERE (basic.vs, copy.vs through proceduralsphere.glsl) to rebuild them from gl_VertexID
+void renderProceduralSphere(int stacks, int slices, float radius);
+void releaseProceduralSphere(void);
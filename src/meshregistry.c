@@ -0,0 +1,371 @@
+#include "meshregistry.h"
+
+#include <string.h>
+
+static int sameKey(const MeshKey *a, const MeshKey *b)
+{
+  return a->generator == b->generator && a->detail[0] == b->detail[0] && a->detail[1] == b->detail[1] &&
+         a->layout == b->layout && a->strips == b->strips && a->optimizeIndices == b->optimizeIndices;
+}
+
+// CPU side of a mesh, touches no GL state so it can run on the worker
+static int generateMeshData(const MeshKey *key, MeshBuild *build)
+{
+  switch (key->generator)
+  {
+  case MESH_ICOSPHERE:
+    generateIcosphereMesh(1.0f, key->detail[0], &build->vertices, &build->indices, &build->vertexCount, &build->indexCount);
+    snprintf(build->name, sizeof(build->name), "icosphere %d", key->detail[0]);
+    break;
+  case MESH_CUBE_SPHERE:
+    generateCubeSphereMesh(1.0f, key->detail[0], &build->vertices, &build->indices, &build->vertexCount, &build->indexCount);
+    snprintf(build->name, sizeof(build->name), "cube sphere %d", key->detail[0]);
+    break;
+  default:
+    generateSphereMesh(1.0f, key->detail[0], key->detail[1], &build->vertices, &build->indices, &build->vertexCount, &build->indexCount);
+    snprintf(build->name, sizeof(build->name), "sphere %dx%d", key->detail[0], key->detail[1]);
+    break;
+  }
+  if (!build->vertices)
+    return 0;
+
+  build->primitive = GL_TRIANGLES;
+  if (key->strips && key->generator == MESH_UV_SPHERE)
+  {
+    // strips already reuse the previous two vertices, the list order is not needed
+    free(build->indices);
+    if (!generateSphereStripIndices(key->detail[0], key->detail[1], &build->indices, &build->indexCount))
+    {
+      free(build->vertices);
+      build->vertices = NULL;
+      return 0;
+    }
+    build->primitive = GL_TRIANGLE_STRIP;
+  }
+  else if (key->optimizeIndices)
+    optimizeMeshIndices(build->name, build->vertices, build->vertexCount, build->indices, build->indexCount);
+  return 1;
+}
+
+static void freeMeshBuild(MeshBuild *build)
+{
+  free(build->vertices);
+  free(build->indices);
+  build->vertices = NULL;
+  build->indices = NULL;
+}
+
+static int uploadMeshData(MeshRegistry *registry, const MeshKey *key, const MeshBuild *build, MeshEntry *entry)
+{
+  GeometryArena *arena = &registry->arenas[key->layout];
+  if (!arena->vao)
+    initGeometryArena(arena, key->layout, ARENA_INITIAL_VERTICES, ARENA_INITIAL_INDEX_BYTES);
+  entry->arenaRange = arenaAddMesh(arena, build->vertices, build->vertexCount, build->indices, build->indexCount, build->primitive, &entry->mesh);
+  return entry->arenaRange >= 0;
+}
+
+// a compaction or growth moves ranges, so every mesh of the arena gets its new offsets
+static void refreshArenaMeshes(MeshRegistry *registry, VertexLayout layout)
+{
+  for (int i = 0; i < MESH_REGISTRY_SIZE; i++)
+  {
+    MeshEntry *entry = &registry->entries[i];
+    if (entry->references && entry->key.layout == layout && !entry->placeholder)
+      arenaMeshOffsets(&registry->arenas[layout], entry->arenaRange, &entry->mesh);
+  }
+  // meshes still being built draw their placeholder, which may have moved too
+  for (int i = 0; i < MESH_REGISTRY_SIZE; i++)
+  {
+    MeshEntry *entry = &registry->entries[i];
+    if (entry->references && entry->placeholder)
+      entry->mesh = entry->placeholder->mesh;
+  }
+}
+
+static MeshEntry *findEntry(MeshRegistry *registry, const MeshKey *key)
+{
+  for (int i = 0; i < MESH_REGISTRY_SIZE; i++)
+  {
+    MeshEntry *entry = &registry->entries[i];
+    if (entry->references && sameKey(&entry->key, key))
+      return entry;
+  }
+  return NULL;
+}
+
+// a released mesh whose job is still running keeps its slot until updateMeshRegistry collects it.
+// Jobs only exist once the worker runs, and from then on the lock guards them
+static MeshEntry *findFreeEntry(MeshRegistry *registry)
+{
+  MeshEntry *found = NULL;
+  if (registry->workerStarted)
+    pthread_mutex_lock(&registry->lock);
+  for (int i = 0; i < MESH_REGISTRY_SIZE && !found; i++)
+  {
+    MeshEntry *entry = &registry->entries[i];
+    if (!entry->references && entry->job == MESH_JOB_NONE)
+      found = entry;
+  }
+  if (registry->workerStarted)
+    pthread_mutex_unlock(&registry->lock);
+  if (found)
+    return found;
+  fprintf(stderr, "Mesh registry is full (%d meshes)\n", MESH_REGISTRY_SIZE);
+  return NULL;
+}
+
+const Mesh *acquireMesh(MeshRegistry *registry, const MeshKey *key)
+{
+  MeshEntry *entry = findEntry(registry, key);
+  if (entry)
+  {
+    entry->references++;
+    return &entry->mesh;
+  }
+
+  entry = findFreeEntry(registry);
+  if (!entry)
+    return NULL;
+  MeshBuild build = {0};
+  if (!generateMeshData(key, &build))
+    return NULL;
+  int uploaded = uploadMeshData(registry, key, &build, entry);
+  freeMeshBuild(&build);
+  if (!uploaded)
+    return NULL;
+  entry->key = *key;
+  entry->references = 1;
+  entry->placeholder = NULL;
+  registry->uploads++;
+  refreshArenaMeshes(registry, key->layout);
+  return &entry->mesh;
+}
+
+static void *meshWorker(void *arg)
+{
+  MeshRegistry *registry = arg;
+  pthread_mutex_lock(&registry->lock);
+  while (!registry->quit)
+  {
+    MeshEntry *entry = NULL;
+    for (int i = 0; i < MESH_REGISTRY_SIZE && !entry; i++)
+    {
+      if (registry->entries[i].job == MESH_JOB_QUEUED)
+        entry = &registry->entries[i];
+    }
+    if (!entry)
+    {
+      pthread_cond_wait(&registry->wake, &registry->lock);
+      continue;
+    }
+
+    // the key and build of a queued entry are left alone by the GL thread until the job ends
+    entry->job = MESH_JOB_BUILDING;
+    pthread_mutex_unlock(&registry->lock);
+    int built = generateMeshData(&entry->key, &entry->build);
+    pthread_mutex_lock(&registry->lock);
+    entry->job = built ? MESH_JOB_BUILT : MESH_JOB_FAILED;
+  }
+  pthread_mutex_unlock(&registry->lock);
+  return NULL;
+}
+
+static int startMeshWorker(MeshRegistry *registry)
+{
+  if (registry->workerStarted)
+    return 1;
+  pthread_mutex_init(&registry->lock, NULL);
+  pthread_cond_init(&registry->wake, NULL);
+  registry->quit = 0;
+  if (pthread_create(&registry->worker, NULL, meshWorker, registry) != 0)
+  {
+    fprintf(stderr, "Could not start the mesh worker thread\n");
+    pthread_cond_destroy(&registry->wake);
+    pthread_mutex_destroy(&registry->lock);
+    return 0;
+  }
+  registry->workerStarted = 1;
+  return 1;
+}
+
+static MeshKey placeholderKey(const MeshKey *key)
+{
+  MeshKey coarse = *key;
+  switch (key->generator)
+  {
+  case MESH_ICOSPHERE:
+    coarse.detail[0] = key->detail[0] < 1 ? key->detail[0] : 1;
+    break;
+  case MESH_CUBE_SPHERE:
+    coarse.detail[0] = key->detail[0] < 3 ? key->detail[0] : 3;
+    break;
+  default:
+    for (int i = 0; i < 2; i++)
+      coarse.detail[i] = key->detail[i] < MESH_PLACEHOLDER_DETAIL ? key->detail[i] : MESH_PLACEHOLDER_DETAIL;
+    break;
+  }
+  return coarse;
+}
+
+const Mesh *acquireMeshAsync(MeshRegistry *registry, const MeshKey *key)
+{
+  MeshKey coarse = placeholderKey(key);
+  MeshEntry *entry = findEntry(registry, key);
+  if (entry)
+  {
+    entry->references++;
+    return &entry->mesh;
+  }
+  if (sameKey(&coarse, key) || !startMeshWorker(registry))
+    return acquireMesh(registry, key);
+
+  // the placeholder is built right here, it is small enough not to hold up the frame
+  const Mesh *placeholder = acquireMesh(registry, &coarse);
+  if (!placeholder)
+    return NULL;
+  entry = findFreeEntry(registry);
+  if (!entry)
+  {
+    releaseMesh(registry, placeholder);
+    return NULL;
+  }
+  entry->key = *key;
+  entry->references = 1;
+  entry->placeholder = findEntry(registry, &coarse);
+  entry->mesh = *placeholder;
+  memset(&entry->build, 0, sizeof(entry->build));
+
+  pthread_mutex_lock(&registry->lock);
+  entry->job = MESH_JOB_QUEUED;
+  pthread_cond_signal(&registry->wake);
+  pthread_mutex_unlock(&registry->lock);
+  return &entry->mesh;
+}
+
+int updateMeshRegistry(MeshRegistry *registry)
+{
+  if (!registry->workerStarted)
+    return 0;
+
+  int swapped = 0;
+  for (int i = 0; i < MESH_REGISTRY_SIZE; i++)
+  {
+    MeshEntry *entry = &registry->entries[i];
+    pthread_mutex_lock(&registry->lock);
+    MeshJobState job = entry->job;
+    pthread_mutex_unlock(&registry->lock);
+    if (job != MESH_JOB_BUILT && job != MESH_JOB_FAILED)
+      continue;
+
+    // an entry released while it was being built only drops the geometry
+    if (entry->references && job == MESH_JOB_FAILED)
+      fprintf(stderr, "Could not generate %s, keeping its placeholder\n", entry->build.name);
+    else if (entry->references)
+    {
+      MeshEntry *placeholder = entry->placeholder;
+      Mesh coarse = entry->mesh;
+      if (uploadMeshData(registry, &entry->key, &entry->build, entry))
+      {
+        entry->placeholder = NULL;
+        registry->uploads++;
+        refreshArenaMeshes(registry, entry->key.layout);
+        releaseMesh(registry, &placeholder->mesh);
+        printf("%s replaced its placeholder\n", entry->build.name);
+        swapped++;
+      }
+      else
+      {
+        entry->mesh = coarse;
+        fprintf(stderr, "Could not upload %s, keeping its placeholder\n", entry->build.name);
+      }
+    }
+    freeMeshBuild(&entry->build);
+
+    pthread_mutex_lock(&registry->lock);
+    entry->job = MESH_JOB_NONE;
+    pthread_mutex_unlock(&registry->lock);
+  }
+  return swapped;
+}
+
+void releaseMesh(MeshRegistry *registry, const Mesh *mesh)
+{
+  if (!mesh)
+    return;
+
+  for (int i = 0; i < MESH_REGISTRY_SIZE; i++)
+  {
+    MeshEntry *entry = &registry->entries[i];
+    if (&entry->mesh != mesh)
+      continue;
+    if (entry->references > 0 && --entry->references == 0)
+    {
+      if (entry->placeholder)
+      {
+        // never uploaded, a queued job is dropped and a running one collected by updateMeshRegistry
+        MeshEntry *placeholder = entry->placeholder;
+        entry->placeholder = NULL;
+        memset(&entry->mesh, 0, sizeof(entry->mesh));
+        pthread_mutex_lock(&registry->lock);
+        if (entry->job == MESH_JOB_QUEUED)
+          entry->job = MESH_JOB_NONE;
+        pthread_mutex_unlock(&registry->lock);
+        releaseMesh(registry, &placeholder->mesh);
+        return;
+      }
+      GeometryArena *arena = &registry->arenas[entry->key.layout];
+      arenaRemoveMesh(arena, entry->arenaRange);
+      memset(&entry->mesh, 0, sizeof(entry->mesh));
+      if (arenaNeedsCompaction(arena) && compactGeometryArena(arena))
+        refreshArenaMeshes(registry, entry->key.layout);
+    }
+    return;
+  }
+  fprintf(stderr, "Released a mesh the registry does not own\n");
+}
+
+void destroyMeshRegistry(MeshRegistry *registry)
+{
+  if (registry->workerStarted)
+  {
+    // a mesh being generated is finished first, anything still queued never starts
+    pthread_mutex_lock(&registry->lock);
+    registry->quit = 1;
+    pthread_cond_signal(&registry->wake);
+    pthread_mutex_unlock(&registry->lock);
+    pthread_join(registry->worker, NULL);
+    pthread_cond_destroy(&registry->wake);
+    pthread_mutex_destroy(&registry->lock);
+    registry->workerStarted = 0;
+  }
+
+  for (int i = 0; i < MESH_REGISTRY_SIZE; i++)
+  {
+    MeshEntry *entry = &registry->entries[i];
+    freeMeshBuild(&entry->build);
+    entry->job = MESH_JOB_NONE;
+    if (!entry->references)
+      continue;
+    fprintf(stderr, "Mesh %d still has %d references\n", i, entry->references);
+    entry->references = 0;
+  }
+  for (int i = 0; i < VERTEX_LAYOUT_COUNT; i++)
+    if (registry->arenas[i].vao)
+      destroyGeometryArena(&registry->arenas[i]);
+}
+
+// unique meshes alive and their GPU memory
+int meshRegistryCount(const MeshRegistry *registry, size_t *bytes)
+{
+  int count = 0;
+  *bytes = 0;
+  for (int i = 0; i < MESH_REGISTRY_SIZE; i++)
+  {
+    // meshes still being generated only have their placeholder's memory
+    if (!registry->entries[i].references || registry->entries[i].placeholder)
+      continue;
+    count++;
+    *bytes += registry->entries[i].mesh.bytes;
+  }
+  return count;
+}
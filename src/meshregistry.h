@@ -0,0 +1,92 @@
+#pragma once
+
+#include <pthread.h>
+
+#include "geometryarena.h"
+#include "meshes.h"
+#include "vertexcache.h"
+
+#define MESH_REGISTRY_SIZE 32
+// stacks and slices of a UV sphere's stand-in while the worker builds it, the other generators get
+// about as many triangles (icosphere 1, cube sphere 3)
+#define MESH_PLACEHOLDER_DETAIL 8
+
+typedef enum
+{
+  MESH_UV_SPHERE,   // generateSphereMesh, detail = stacks, slices
+  MESH_ICOSPHERE,   // generateIcosphereMesh, detail = subdivisions
+  MESH_CUBE_SPHERE  // generateCubeSphereMesh, detail = quads per cube edge
+} MeshGenerator;
+
+// everything that decides the uploaded geometry, meshes are built with radius 1 and scaled by the
+// model matrix so bodies of any size share them
+typedef struct
+{
+  MeshGenerator generator;
+  int detail[2];
+  VertexLayout layout;
+  int strips;          // triangle strips, UV spheres only
+  int optimizeIndices; // vertex cache and overdraw order for triangle lists
+} MeshKey;
+
+// generated geometry waiting for its upload
+typedef struct
+{
+  Vertex *vertices;
+  unsigned int *indices;
+  int vertexCount, indexCount;
+  GLenum primitive;
+  char name[64];
+} MeshBuild;
+
+typedef enum
+{
+  MESH_JOB_NONE,
+  MESH_JOB_QUEUED,
+  MESH_JOB_BUILDING,
+  MESH_JOB_BUILT, // build holds the geometry until updateMeshRegistry uploads it
+  MESH_JOB_FAILED
+} MeshJobState;
+
+typedef struct MeshEntry
+{
+  MeshKey key;
+  Mesh mesh;
+  int arenaRange; // ArenaRange of the mesh in the arena of its layout
+  int references; // 0 = free slot, unless a job is still running for it
+
+  // built on the worker thread, until then mesh is a copy of the placeholder's
+  struct MeshEntry *placeholder; // NULL once the mesh is uploaded
+  MeshJobState job;              // guarded by the registry lock
+  MeshBuild build;
+} MeshEntry;
+
+typedef struct
+{
+  MeshEntry entries[MESH_REGISTRY_SIZE];
+  GeometryArena arenas[VERTEX_LAYOUT_COUNT]; // created on first use of the layout
+  int uploads; // meshes built since the registry was created
+
+  // generates the meshes of acquireMeshAsync, started on first use. GL calls stay on the caller's thread
+  pthread_t worker;
+  int workerStarted;
+  pthread_mutex_t lock;
+  pthread_cond_t wake;
+  int quit;
+} MeshRegistry;
+
+// returns the shared mesh for the key, generating and uploading it on first use, NULL on failure
+const Mesh *acquireMesh(MeshRegistry *registry, const MeshKey *key);
+// same, but a new mesh is generated on the worker thread and drawn as a coarse placeholder until
+// updateMeshRegistry swaps it in. The pointer stays the same throughout
+const Mesh *acquireMeshAsync(MeshRegistry *registry, const MeshKey *key);
+// uploads whatever the worker finished, call once per frame on the GL thread. Returns the number
+// of meshes that replaced their placeholder
+int updateMeshRegistry(MeshRegistry *registry);
+// drops one reference, the last one frees the mesh's arena range and compacts the arena once
+// half of it is holes (pointers to the other meshes stay valid)
+void releaseMesh(MeshRegistry *registry, const Mesh *mesh);
+// stops the worker, deletes whatever is left and reports meshes that were never released
+void destroyMeshRegistry(MeshRegistry *registry);
+
+int meshRegistryCount(const MeshRegistry *registry, size_t *bytes);
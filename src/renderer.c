@@ -0,0 +1,800 @@
+#include "renderer.h"
+#include "files.h"
+
+#include <GLFW/glfw3.h>
+
+// column-major a * b, multiplyMatrices4x4 indexes its arguments row-major
+static void multiplyColumnMajor(const float a[16], const float b[16], float result[16])
+{
+  multiplyMatrices4x4(b, a, result);
+}
+
+static void updateCameraTransforms(CameraTransforms *camera, const FrameParams *frame)
+{
+  if (camera->version && memcmp(camera->view, frame->view, sizeof(camera->view)) == 0 &&
+      memcmp(camera->projection, frame->projection, sizeof(camera->projection)) == 0)
+    return;
+
+  memcpy(camera->view, frame->view, sizeof(camera->view));
+  memcpy(camera->projection, frame->projection, sizeof(camera->projection));
+  multiplyColumnMajor(camera->projection, camera->view, camera->viewProj);
+  camera->version++;
+}
+
+// frame model with the unit sphere scaled to radius
+static void sphereModel(const float frameModel[16], float radius, float model[16])
+{
+  float scale[16];
+  create_identity_matrix(scale);
+  scaleMatrix4x4ColumnMajor(scale, radius, radius, radius);
+  multiplyColumnMajor(frameModel, scale, model);
+}
+
+static void updateDrawTransforms(DrawTransforms *draw, const CameraTransforms *camera, const float model[16])
+{
+  int modelChanged = !draw->cameraVersion || memcmp(draw->model, model, sizeof(draw->model)) != 0;
+  if (!modelChanged && draw->cameraVersion == camera->version)
+    return;
+
+  if (modelChanged)
+  {
+    memcpy(draw->model, model, sizeof(draw->model));
+    create_normal_matrix(draw->model, draw->normalMatrix);
+  }
+  multiplyColumnMajor(camera->viewProj, draw->model, draw->mvp);
+  draw->cameraVersion = camera->version;
+}
+
+static void getDepthRange(Renderer *renderer, float *near, float *far)
+{
+  switch (renderer->settings.depthMode)
+  {
+  case DEPTH_REVERSED_Z:
+    *near = WIDE_DEPTH_NEAR;
+    *far = INFINITY;
+    break;
+  case DEPTH_LOGARITHMIC:
+    *near = WIDE_DEPTH_NEAR;
+    *far = LOG_DEPTH_FAR;
+    break;
+  default:
+    *near = CAMERA_NEAR;
+    *far = CAMERA_FAR;
+    break;
+  }
+}
+
+// impostor.vs quad around the sphere of the shader's model matrix as seen by camera
+static void drawImpostorQuad(Renderer *renderer, unsigned int shader, CameraTransforms *camera, float near)
+{
+  // billboard.fs never reads the view ray, so the full screen fallback's matrices are optimized out
+  if (glGetUniformLocation(shader, "view") >= 0)
+  {
+    set_matrix_uniform(shader, "view", camera->view);
+    set_matrix_uniform(shader, "projection", camera->projection);
+  }
+  set_matrix_uniform(shader, "viewProj", camera->viewProj);
+  set_float_uniform(shader, "nearPlane", near);
+  // a single layer, whichever way the quad faces
+  glDisable(GL_CULL_FACE);
+  glBindVertexArray(renderer->emptyVao);
+  glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+  glBindVertexArray(0);
+}
+
+// one of the two spheres in whichever way the settings build them, uniforms of the pass are set
+static void drawSphere(Renderer *renderer, unsigned int shader, const Mesh *mesh)
+{
+  if (renderer->settings.impostorSpheres)
+  {
+    float near, far;
+    getDepthRange(renderer, &near, &far);
+    drawImpostorQuad(renderer, shader, &renderer->camera, near);
+  }
+  else if (renderer->settings.proceduralSpheres)
+    renderProceduralSphere(renderer->settings.sphereDetail, renderer->settings.sphereDetail, 1.0f);
+  else if (renderer->settings.tessellation)
+  {
+    set_float_uniform(shader, "pixelsPerUnit", renderer->camera.projection[5] * 0.5f * renderer->graph.height);
+    set_float_uniform(shader, "edgePixels", TESS_EDGE_PIXELS);
+    set_float_uniform(shader, "maxTessLevel", TESS_MAX_LEVEL);
+    renderMeshPatches(mesh);
+  }
+  else
+    renderMesh(mesh);
+}
+
+static void setSurfaceUniforms(unsigned int shader, FrameParams *frame)
+{
+  // uniform vec3 lightPos;
+  set_vec3fv_uniform(shader, "lightPos", frame->lightPos);
+  // uniform vec3 viewPos;
+  set_vec3fv_uniform(shader, "viewPos", frame->viewPos);
+  // uniform vec3 surfaceColor;
+  set_vec3f_uniform(shader, "surfaceColor", 0.1f, 0.3f, 0.4f);
+}
+
+static void setScatteringUniforms(Renderer *renderer, unsigned int shader)
+{
+  FrameParams *frame = &renderer->frame;
+  set_vec3fv_uniform(shader, "viewPos", frame->viewPos);
+  set_vec3fv_uniform(shader, "sunPos", frame->sunDirection);
+  set_int_uniform(shader, "viewSamples", 16);
+  set_int_uniform(shader, "lightSamples", 8);
+  set_float_uniform(shader, "sunIntensity", 20.0f);
+  set_float_uniform(shader, "planetRadius", renderer->planetRadius);
+  set_float_uniform(shader, "atmosphereRadius", renderer->atmosphereRadius);
+  set_vec3f_uniform(shader, "rCoeff", 5.8e-3f, 13.5e-3f, 33.1e-3f);
+  set_float_uniform(shader, "mCoeff", 21e-3f);
+  set_float_uniform(shader, "rHeight", 7.994);
+  set_float_uniform(shader, "mHeight", 1.200);
+  set_float_uniform(shader, "g", 0.888);
+}
+
+// planet and atmosphere as seen from the viewer into an atlas tile. The tile camera looks at the
+// center with the basis impostor.vs gives the billboard quad and a field of view that just holds
+// the atmosphere, so the tile maps onto the quad corner to corner
+static void renderBillboardTile(Renderer *renderer, int tile)
+{
+  FrameParams *frame = &renderer->frame;
+  float planetModel[16], atmosphereModel[16];
+  sphereModel(frame->model, renderer->planetRadius, planetModel);
+  sphereModel(frame->model, renderer->atmosphereRadius, atmosphereModel);
+
+  vec3 eye = vec3_load(frame->viewPos);
+  vec3 toCenter = vec3_sub(vec3_make(atmosphereModel[12], atmosphereModel[13], atmosphereModel[14]), eye);
+  float distance = vec3_length(toCenter);
+  float radius = renderer->atmosphereRadius;
+  vec3 forward = vec3_scale(toCenter, 1.0f / distance);
+  vec3 right = vec3_normalize(vec3_cross(forward, fabsf(forward.y) < 0.99f ? vec3_make(0.0f, 1.0f, 0.0f) : vec3_make(1.0f, 0.0f, 0.0f)));
+  vec3 up = vec3_cross(right, forward);
+  float near = (distance - radius) * 0.25f;
+
+  mat4 view = {{right.x, up.x, -forward.x, 0.0f, right.y, up.y, -forward.y, 0.0f, right.z, up.z, -forward.z, 0.0f,
+                -vec3_dot(right, eye), -vec3_dot(up, eye), vec3_dot(forward, eye), 1.0f}};
+  mat4 projection = MAT4_PERSPECTIVE_INIT(sqrtf(distance * distance - radius * radius) / radius, 1.0f, near, distance + radius);
+  mat4 viewProj = mat4_mul(&projection, &view);
+  CameraTransforms camera;
+  mat4_store(&view, camera.view);
+  mat4_store(&projection, camera.projection);
+  mat4_store(&viewProj, camera.viewProj);
+
+  bindBillboardTile(&renderer->billboards, tile);
+  glDisable(GL_DEPTH_TEST);
+  glDepthMask(GL_FALSE);
+  glDisable(GL_BLEND);
+
+  glUseProgram(renderer->tilePlanetShader);
+  set_matrix_uniform(renderer->tilePlanetShader, "model", planetModel);
+  setSurfaceUniforms(renderer->tilePlanetShader, frame);
+  drawImpostorQuad(renderer, renderer->tilePlanetShader, &camera, near);
+
+  // the atmosphere adds its light and leaves the planet's coverage alone
+  glEnable(GL_BLEND);
+  glBlendFuncSeparate(GL_ONE, GL_ONE, GL_ZERO, GL_ONE);
+  glUseProgram(renderer->tileAtmosphereShader);
+  set_matrix_uniform(renderer->tileAtmosphereShader, "model", atmosphereModel);
+  setScatteringUniforms(renderer, renderer->tileAtmosphereShader);
+  drawImpostorQuad(renderer, renderer->tileAtmosphereShader, &camera, near);
+
+  glDisable(GL_BLEND);
+  glDepthMask(GL_TRUE);
+  glEnable(GL_DEPTH_TEST);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+// below BILLBOARD_MAX_PIXELS the planet and its atmosphere come from an atlas tile, rendered again
+// only once the view or the sun has moved past the tile's tolerance
+static void updateBillboards(Renderer *renderer)
+{
+  FrameParams *frame = &renderer->frame;
+  renderer->billboardTile = -1;
+  if (!renderer->settings.billboards)
+    return;
+  beginBillboardFrame(&renderer->billboards);
+
+  vec3 center = vec3_make(frame->model[12], frame->model[13], frame->model[14]);
+  vec3 toViewer = vec3_sub(vec3_load(frame->viewPos), center);
+  float distance = vec3_length(toViewer);
+  float radius = renderer->atmosphereRadius;
+  if (distance <= radius)
+    return;
+  float pixels = 2.0f * radius * renderer->camera.projection[5] * 0.5f * renderer->graph.height / distance;
+  if (pixels > BILLBOARD_MAX_PIXELS)
+    return;
+
+  int stale;
+  vec3 viewDirection = vec3_scale(toViewer, 1.0f / distance);
+  vec3 sunDirection = vec3_normalize(vec3_load(frame->sunDirection));
+  int tile = acquireBillboardTile(&renderer->billboards, BILLBOARD_PLANET, viewDirection, sunDirection, distance, &stale);
+  if (tile < 0)
+    return;
+  if (stale)
+    renderBillboardTile(renderer, tile);
+  renderer->billboardTile = tile;
+}
+
+// planet surface, writes color and depth
+static void planetPass(RenderGraph *graph, void *userData)
+{
+  Renderer *renderer = userData;
+  (void)graph;
+  FrameParams *frame = &renderer->frame;
+
+  int reversed = renderer->settings.depthMode == DEPTH_REVERSED_Z;
+  glClearColor(0.0f, 01.0f, 0.0f, 1.0f);
+  glClearDepth(reversed ? 0.0 : 1.0);
+  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+  // a billboard is composited by the atmosphere pass instead
+  if (renderer->billboardTile >= 0)
+    return;
+
+  glEnable(GL_DEPTH_TEST);
+  glDepthMask(GL_TRUE);                         // Enable depth writing
+  glDepthFunc(reversed ? GL_GREATER : GL_LESS); // near is 1 with reversed-Z
+  glDisable(GL_BLEND);
+  glUseProgram(renderer->basicShader);
+  if (renderer->settings.depthMode == DEPTH_LOGARITHMIC)
+    set_float_uniform(renderer->basicShader, "logDepthCoef", 2.0f / log2f(LOG_DEPTH_FAR + 1.0f));
+  // set uniforms
+  DrawTransforms *transforms = &renderer->planetTransforms;
+  float model[16];
+  sphereModel(frame->model, renderer->planetRadius, model);
+  updateDrawTransforms(transforms, &renderer->camera, model);
+  // uniform mat4 model;
+  set_matrix_uniform(renderer->basicShader, "model", transforms->model);
+  // uniform mat4 mvp;
+  set_matrix_uniform(renderer->basicShader, "mvp", transforms->mvp);
+  // uniform mat3 normalMatrix;
+  set_matrix3_uniform(renderer->basicShader, "normalMatrix", transforms->normalMatrix);
+  setSurfaceUniforms(renderer->basicShader, frame);
+
+  drawSphere(renderer, renderer->basicShader, renderer->planetMesh);
+}
+
+static void bindTexture(unsigned int shader, const char *uniformName, int unit, GLuint texture)
+{
+  glActiveTexture(GL_TEXTURE0 + unit);
+  glBindTexture(GL_TEXTURE_2D, texture);
+  set_int_uniform(shader, uniformName, unit);
+}
+
+// the planet's atlas tile over whatever the planet pass cleared to, premultiplied by its coverage
+static void drawBillboard(Renderer *renderer)
+{
+  unsigned int shader = renderer->billboardShader;
+  float model[16], offset[2], near, far;
+  sphereModel(renderer->frame.model, renderer->atmosphereRadius, model);
+  billboardTileOffset(renderer->billboardTile, offset);
+  getDepthRange(renderer, &near, &far);
+
+  glDisable(GL_DEPTH_TEST);
+  glDepthMask(GL_FALSE);
+  glEnable(GL_BLEND);
+  glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+  glUseProgram(shader);
+  set_matrix_uniform(shader, "model", model);
+  set_vec3fv_uniform(shader, "viewPos", renderer->frame.viewPos);
+  bindTexture(shader, "atlas", 0, renderer->billboards.texture);
+  set_vec2f_uniform(shader, "tileOffset", offset[0], offset[1]);
+  set_float_uniform(shader, "tileScale", 1.0f / BILLBOARD_ATLAS_TILES);
+  drawImpostorQuad(renderer, shader, &renderer->camera, near);
+
+  glDisable(GL_BLEND);
+  glDepthMask(GL_TRUE);
+  glEnable(GL_DEPTH_TEST);
+}
+
+// in-scattered light of the atmosphere shell, added on top of the resolved planet
+static void atmospherePass(RenderGraph *graph, void *userData)
+{
+  Renderer *renderer = userData;
+  FrameParams *frame = &renderer->frame;
+  if (renderer->billboardTile >= 0)
+  {
+    drawBillboard(renderer);
+    return;
+  }
+
+  // every pixel covered by the shell is shaded exactly once from its inner faces,
+  // copy.fs stops the ray at the planet surface itself
+  glDisable(GL_DEPTH_TEST);
+  glDepthMask(GL_FALSE);
+  glEnable(GL_CULL_FACE);
+  glCullFace(GL_FRONT);
+  glEnable(GL_BLEND);
+  glBlendFunc(GL_ONE, GL_ONE);
+
+  glUseProgram(renderer->atmosphereShader);
+  DrawTransforms *transforms = &renderer->atmosphereTransforms;
+  float model[16];
+  sphereModel(frame->model, renderer->atmosphereRadius, model);
+  updateDrawTransforms(transforms, &renderer->camera, model);
+  set_matrix_uniform(renderer->atmosphereShader, "model", transforms->model);
+  set_matrix_uniform(renderer->atmosphereShader, "mvp", transforms->mvp);
+
+  // copy uniforms
+  setScatteringUniforms(renderer, renderer->atmosphereShader);
+
+  // the ray march also ends at whatever the planet pass left in the depth buffer
+  float near, far;
+  getDepthRange(renderer, &near, &far);
+  bindTexture(renderer->atmosphereShader, "sceneDepth", 0, rgGetTexture(graph, renderer->resolvedDepth));
+  set_int_uniform(renderer->atmosphereShader, "depthMode", renderer->settings.depthMode);
+  set_vec2f_uniform(renderer->atmosphereShader, "depthRange", near, isinf(far) ? 0.0f : far);
+  set_vec3f_uniform(renderer->atmosphereShader, "viewForward", -frame->view[2], -frame->view[6], -frame->view[10]);
+
+  drawSphere(renderer, renderer->atmosphereShader, renderer->atmosphereMesh);
+
+  glDisable(GL_BLEND);
+  glDisable(GL_CULL_FACE);
+  glCullFace(GL_BACK);
+  glDepthMask(GL_TRUE);
+  glEnable(GL_DEPTH_TEST);
+}
+
+static void drawFullscreenTriangle(Renderer *renderer)
+{
+  glDisable(GL_DEPTH_TEST);
+  glBindVertexArray(renderer->emptyVao);
+  glDrawArrays(GL_TRIANGLES, 0, 3);
+  glBindVertexArray(0);
+  glEnable(GL_DEPTH_TEST);
+}
+
+// resolves the multisampled planet, only its edges needed the extra samples
+static void resolvePass(RenderGraph *graph, void *userData)
+{
+  Renderer *renderer = userData;
+  rgBlitToTarget(graph, renderer->sceneColor);
+  rgBlitToTarget(graph, renderer->sceneDepth);
+}
+
+// log luminance of the scene, reduced to its average by the mip chain without a CPU readback
+static void luminancePass(RenderGraph *graph, void *userData)
+{
+  Renderer *renderer = userData;
+  glUseProgram(renderer->luminanceShader);
+  bindTexture(renderer->luminanceShader, "hdrColor", 0, rgGetTexture(graph, renderer->hdrColor));
+  drawFullscreenTriangle(renderer);
+
+  glBindTexture(GL_TEXTURE_2D, rgGetTexture(graph, renderer->logLuminance));
+  glGenerateMipmap(GL_TEXTURE_2D);
+  glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+// moves the persistent 1x1 adapted luminance towards this frame's average
+static void adaptationPass(RenderGraph *graph, void *userData)
+{
+  Renderer *renderer = userData;
+  float blend = 1.0f;
+  if (renderer->exposureValid)
+    blend = 1.0f - expf(-renderer->frame.deltaTime * EXPOSURE_ADAPTATION_RATE);
+  renderer->exposureValid = 1;
+
+  glUseProgram(renderer->adaptationShader);
+  bindTexture(renderer->adaptationShader, "logLuminance", 0, rgGetTexture(graph, renderer->logLuminance));
+  set_float_uniform(renderer->adaptationShader, "topLevel", log2f(LUMINANCE_SIZE));
+
+  glEnable(GL_BLEND);
+  glBlendColor(0.0f, 0.0f, 0.0f, blend);
+  glBlendFunc(GL_CONSTANT_ALPHA, GL_ONE_MINUS_CONSTANT_ALPHA);
+  drawFullscreenTriangle(renderer);
+  glDisable(GL_BLEND);
+}
+
+// single exposure and tone mapping, into the window or the FXAA input
+static void tonemapPass(RenderGraph *graph, void *userData)
+{
+  Renderer *renderer = userData;
+  glUseProgram(renderer->tonemapShader);
+  bindTexture(renderer->tonemapShader, "hdrColor", 0, rgGetTexture(graph, renderer->hdrColor));
+  bindTexture(renderer->tonemapShader, "adaptedLuminance", 1, rgGetTexture(graph, renderer->exposure));
+  set_float_uniform(renderer->tonemapShader, "exposureKey", EXPOSURE_KEY);
+  set_vec2f_uniform(renderer->tonemapShader, "exposureRange", EXPOSURE_MIN, EXPOSURE_MAX);
+  drawFullscreenTriangle(renderer);
+}
+
+// post-process antialiasing of the tone mapped image into the window
+static void fxaaPass(RenderGraph *graph, void *userData)
+{
+  Renderer *renderer = userData;
+  int width, height;
+  rgGetSize(graph, renderer->ldrColor, &width, &height);
+  glUseProgram(renderer->fxaaShader);
+  bindTexture(renderer->fxaaShader, "ldrColor", 0, rgGetTexture(graph, renderer->ldrColor));
+  set_vec2f_uniform(renderer->fxaaShader, "texelSize", 1.0f / width, 1.0f / height);
+  drawFullscreenTriangle(renderer);
+}
+
+static int buildRenderGraph(Renderer *renderer, int width, int height)
+{
+  RenderGraph *graph = &renderer->graph;
+  int msaa = renderer->settings.antialiasing == AA_MSAA;
+  int fxaa = renderer->settings.antialiasing == AA_FXAA;
+  GLenum depthFormat = renderer->settings.depthMode == DEPTH_STANDARD ? GL_DEPTH_COMPONENT24 : GL_DEPTH_COMPONENT32F;
+
+  rgInit(graph, width, height);
+  renderer->hdrColor = rgCreateTexture(graph, "hdrColor", (RGTextureDesc){.format = GL_RGBA16F});
+  renderer->resolvedDepth = rgCreateTexture(graph, "resolvedDepth", (RGTextureDesc){.format = depthFormat});
+  renderer->sceneColor = renderer->hdrColor;
+  renderer->sceneDepth = renderer->resolvedDepth;
+  if (msaa)
+  {
+    renderer->sceneColor = rgCreateTexture(graph, "sceneColor", (RGTextureDesc){.format = GL_RGBA16F, .samples = MSAA_SAMPLES});
+    renderer->sceneDepth = rgCreateTexture(graph, "sceneDepth", (RGTextureDesc){.format = depthFormat, .samples = MSAA_SAMPLES});
+  }
+  renderer->logLuminance = rgCreateTexture(graph, "logLuminance", (RGTextureDesc){.format = GL_R16F, .width = LUMINANCE_SIZE, .height = LUMINANCE_SIZE, .mipmaps = 1});
+  renderer->exposure = rgImportTexture(graph, "exposure", renderer->adaptedLuminance, 1, 1, GL_R16F);
+  renderer->ldrColor = fxaa ? rgCreateTexture(graph, "ldrColor", (RGTextureDesc){.format = GL_RGBA8}) : RG_BACKBUFFER;
+
+  int planet = rgAddPass(graph, "planet", planetPass, renderer);
+  rgWrite(graph, planet, renderer->sceneColor);
+  rgWrite(graph, planet, renderer->sceneDepth);
+
+  if (msaa)
+  {
+    int resolve = rgAddPass(graph, "resolve", resolvePass, renderer);
+    rgRead(graph, resolve, renderer->sceneColor);
+    rgRead(graph, resolve, renderer->sceneDepth);
+    rgWrite(graph, resolve, renderer->hdrColor);
+    rgWrite(graph, resolve, renderer->resolvedDepth);
+  }
+
+  // shading the shell per sample would cost MSAA_SAMPLES times the bandwidth for a soft gradient
+  int atmosphere = rgAddPass(graph, "atmosphere", atmospherePass, renderer);
+  rgRead(graph, atmosphere, renderer->resolvedDepth);
+  rgWrite(graph, atmosphere, renderer->hdrColor);
+
+  int luminance = rgAddPass(graph, "luminance", luminancePass, renderer);
+  rgRead(graph, luminance, renderer->hdrColor);
+  rgWrite(graph, luminance, renderer->logLuminance);
+
+  int adaptation = rgAddPass(graph, "adaptation", adaptationPass, renderer);
+  rgRead(graph, adaptation, renderer->logLuminance);
+  rgWrite(graph, adaptation, renderer->exposure);
+
+  int tonemap = rgAddPass(graph, "tonemap", tonemapPass, renderer);
+  rgRead(graph, tonemap, renderer->hdrColor);
+  rgRead(graph, tonemap, renderer->exposure);
+  rgWrite(graph, tonemap, renderer->ldrColor);
+
+  if (fxaa)
+  {
+    int antialias = rgAddPass(graph, "fxaa", fxaaPass, renderer);
+    rgRead(graph, antialias, renderer->ldrColor);
+    rgWrite(graph, antialias, RG_BACKBUFFER);
+  }
+
+  if (!rgCompile(graph))
+    return 0;
+  rgPrint(graph);
+  return 1;
+}
+
+int initRenderer(Renderer *renderer, const RendererSettings *settings, float planetRadius, float atmosphereRadius, int width, int height)
+{
+  memset(renderer, 0, sizeof(*renderer));
+  renderer->settings = *settings;
+  if (renderer->settings.framesInFlight < 1 || renderer->settings.framesInFlight > MAX_FRAMES_IN_FLIGHT)
+    renderer->settings.framesInFlight = DEFAULT_FRAMES_IN_FLIGHT;
+  if (renderer->settings.sphereDetail < 3)
+    renderer->settings.sphereDetail = SPHERE_DETAIL;
+  renderer->planetRadius = planetRadius;
+  renderer->atmosphereRadius = atmosphereRadius;
+
+  // depth
+  if (renderer->settings.depthMode == DEPTH_REVERSED_Z && !GLAD_GL_VERSION_4_5)
+  {
+    printf("glClipControl is not available, using logarithmic depth instead of reversed-Z\n");
+    renderer->settings.depthMode = DEPTH_LOGARITHMIC;
+  }
+  if (renderer->settings.depthMode == DEPTH_REVERSED_Z)
+    glClipControl(GL_LOWER_LEFT, GL_ZERO_TO_ONE);
+  int logDepth = renderer->settings.depthMode == DEPTH_LOGARITHMIC;
+
+  // impostors replace the sphere geometry altogether
+  if (renderer->settings.impostorSpheres && (renderer->settings.proceduralSpheres || renderer->settings.tessellation))
+  {
+    printf("impostor spheres have no sphere geometry, ignoring --procedural and --tessellation\n");
+    renderer->settings.proceduralSpheres = 0;
+    renderer->settings.tessellation = 0;
+  }
+
+  // tessellation
+  if (renderer->settings.tessellation && renderer->settings.proceduralSpheres)
+  {
+    printf("procedural spheres have no base mesh to tessellate, drawing them untessellated\n");
+    renderer->settings.tessellation = 0;
+  }
+  if (renderer->settings.tessellation && !GLAD_GL_VERSION_4_0)
+  {
+    printf("tessellation shaders need GL 4.0, using the fixed %dx%d sphere instead\n", renderer->settings.sphereDetail,
+           renderer->settings.sphereDetail);
+    renderer->settings.tessellation = 0;
+  }
+
+  // shaders
+  char defines[128] = "";
+  if (logDepth)
+    strcat(defines, "#define LOG_DEPTH\n");
+  if (renderer->settings.proceduralSpheres)
+    strcat(defines, "#define PROCEDURAL_SPHERE\n");
+  else if (renderer->settings.vertexLayout == VERTEX_LAYOUT_SPHERE)
+    strcat(defines, "#define SPHERE_NORMALS\n");
+  else if (renderer->settings.vertexLayout == VERTEX_LAYOUT_OCTAHEDRAL)
+    strcat(defines, "#define OCTAHEDRAL_NORMALS\n");
+  if (renderer->settings.impostorSpheres)
+  {
+    char impostorDefines[64] = "#define IMPOSTOR\n";
+    if (logDepth)
+      strcat(impostorDefines, "#define LOG_DEPTH\n");
+    else if (renderer->settings.depthMode == DEPTH_REVERSED_Z)
+      strcat(impostorDefines, "#define REVERSED_Z\n");
+    renderer->basicShader = create_shader_program_defines("../src/shaders/impostor.vs", "../src/shaders/phong.fs", impostorDefines);
+    renderer->atmosphereShader = create_shader_program_defines("../src/shaders/impostor.vs", "../src/shaders/copy.fs", NULL);
+  }
+  else if (renderer->settings.tessellation)
+  {
+    renderer->basicShader = create_shader_program_stages("../src/shaders/sphere.vs", "../src/shaders/sphere.tcs", "../src/shaders/sphere.tes",
+                                                         "../src/shaders/phong.fs", logDepth ? "#define LOG_DEPTH" : NULL);
+    renderer->atmosphereShader = create_shader_program_stages("../src/shaders/sphere.vs", "../src/shaders/sphere.tcs", "../src/shaders/sphere.tes",
+                                                              "../src/shaders/copy.fs", "#define ATMOSPHERE");
+  }
+  else
+  {
+    renderer->basicShader = create_shader_program_defines("../src/shaders/basic.vs", "../src/shaders/phong.fs", defines);
+    renderer->atmosphereShader = create_shader_program_defines("../src/shaders/copy.vs", "../src/shaders/copy.fs", renderer->settings.proceduralSpheres ? "#define PROCEDURAL_SPHERE" : NULL);
+  }
+  renderer->luminanceShader = create_shader_program("../src/shaders/fullscreen.vs", "../src/shaders/luminance.fs");
+  renderer->adaptationShader = create_shader_program("../src/shaders/fullscreen.vs", "../src/shaders/adaptation.fs");
+  renderer->tonemapShader = create_shader_program("../src/shaders/fullscreen.vs", "../src/shaders/tonemap.fs");
+  renderer->fxaaShader = create_shader_program("../src/shaders/fullscreen.vs", "../src/shaders/fxaa.fs");
+  if (!renderer->basicShader || !renderer->atmosphereShader || !renderer->luminanceShader ||
+      !renderer->adaptationShader || !renderer->tonemapShader || !renderer->fxaaShader)
+    return 0;
+
+  // billboards, tiles are ray traced whichever way the spheres themselves are drawn
+  if (renderer->settings.billboards)
+  {
+    renderer->billboardShader = create_shader_program("../src/shaders/impostor.vs", "../src/shaders/billboard.fs");
+    renderer->tilePlanetShader = create_shader_program_defines("../src/shaders/impostor.vs", "../src/shaders/phong.fs", "#define IMPOSTOR");
+    renderer->tileAtmosphereShader = create_shader_program_defines("../src/shaders/impostor.vs", "../src/shaders/copy.fs", "#define NO_SCENE_DEPTH");
+    if (!renderer->billboardShader || !renderer->tilePlanetShader || !renderer->tileAtmosphereShader ||
+        !initBillboardAtlas(&renderer->billboards))
+      return 0;
+    printf("billboards below %.0f pixels, %d tiles of %dx%d\n", BILLBOARD_MAX_PIXELS, BILLBOARD_TILE_COUNT,
+           BILLBOARD_TILE_SIZE, BILLBOARD_TILE_SIZE);
+  }
+  renderer->billboardTile = -1;
+
+  // meshes
+  if (renderer->settings.impostorSpheres)
+    printf("impostor spheres, 4 vertices per body\n");
+  else if (renderer->settings.proceduralSpheres)
+    printf("procedural spheres, no vertex data\n");
+  else
+  {
+    // planet and atmosphere differ only in radius and share one mesh, patches need a triangle list.
+    // Detailed spheres are generated on the mesh worker so the first frame does not wait for them
+    int tessellation = renderer->settings.tessellation;
+    int detail = tessellation ? TESS_BASE_DETAIL : renderer->settings.sphereDetail;
+    MeshKey sphere = {MESH_UV_SPHERE, {detail, detail}, renderer->settings.vertexLayout,
+                      renderer->settings.triangleStrips && !tessellation, renderer->settings.optimizeIndices};
+    renderer->planetMesh = acquireMeshAsync(&renderer->meshes, &sphere);
+    renderer->atmosphereMesh = acquireMeshAsync(&renderer->meshes, &sphere);
+    if (!renderer->planetMesh || !renderer->atmosphereMesh)
+      return 0;
+    size_t bytes;
+    int unique = meshRegistryCount(&renderer->meshes, &bytes);
+    printf("%s vertex layout, %d unique mesh%s for 2 objects, %zu bytes\n", vertexLayoutName(renderer->settings.vertexLayout),
+           unique, unique == 1 ? "" : "es", bytes);
+    if (detail > MESH_PLACEHOLDER_DETAIL)
+      printf("generating the %dx%d sphere in the background, drawing a %dx%d one until it is ready\n", detail, detail,
+             MESH_PLACEHOLDER_DETAIL, MESH_PLACEHOLDER_DETAIL);
+    if (tessellation)
+      printf("tessellating a %dx%d base sphere to %.0f pixel edges\n", detail, detail, TESS_EDGE_PIXELS);
+  }
+  glGenVertexArrays(1, &renderer->emptyVao);
+
+  // adapted luminance survives between frames so it lives outside the transient pool. It starts at a
+  // defined value, since even the first frame's full-weight blend keeps a NaN (0 * NaN) forever
+  float initialLuminance = 1.0f;
+  glGenTextures(1, &renderer->adaptedLuminance);
+  glBindTexture(GL_TEXTURE_2D, renderer->adaptedLuminance);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_R16F, 1, 1, 0, GL_RED, GL_FLOAT, &initialLuminance);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    glGenQueries(1, &renderer->frameSlots[i].timer);
+
+  return buildRenderGraph(renderer, width, height);
+}
+
+void destroyRenderer(Renderer *renderer)
+{
+  for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+  {
+    if (renderer->frameSlots[i].fence)
+      glDeleteSync(renderer->frameSlots[i].fence);
+    glDeleteQueries(1, &renderer->frameSlots[i].timer);
+  }
+  rgDestroy(&renderer->graph);
+  releaseMesh(&renderer->meshes, renderer->planetMesh);
+  releaseMesh(&renderer->meshes, renderer->atmosphereMesh);
+  destroyMeshRegistry(&renderer->meshes);
+  releaseProceduralSphere();
+  glDeleteVertexArrays(1, &renderer->emptyVao);
+  glDeleteTextures(1, &renderer->adaptedLuminance);
+  glDeleteProgram(renderer->basicShader);
+  glDeleteProgram(renderer->atmosphereShader);
+  glDeleteProgram(renderer->luminanceShader);
+  glDeleteProgram(renderer->adaptationShader);
+  glDeleteProgram(renderer->tonemapShader);
+  glDeleteProgram(renderer->fxaaShader);
+  if (renderer->settings.billboards)
+  {
+    destroyBillboardAtlas(&renderer->billboards);
+    glDeleteProgram(renderer->billboardShader);
+    glDeleteProgram(renderer->tilePlanetShader);
+    glDeleteProgram(renderer->tileAtmosphereShader);
+  }
+}
+
+void resizeRenderer(Renderer *renderer, int width, int height)
+{
+  rgResize(&renderer->graph, width, height);
+}
+
+void renderFrame(Renderer *renderer, const FrameParams *frame)
+{
+  FrameSlot *slot = &renderer->frameSlots[renderer->frameIndex % renderer->settings.framesInFlight];
+  renderer->frame = *frame;
+  updateMeshRegistry(&renderer->meshes);
+  updateCameraTransforms(&renderer->camera, frame);
+  glBeginQuery(GL_TIME_ELAPSED, slot->timer);
+  updateBillboards(renderer);
+  glPolygonMode(GL_FRONT_AND_BACK, frame->wireframe ? GL_LINE : GL_FILL);
+  rgExecute(&renderer->graph);
+  glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+  glEndQuery(GL_TIME_ELAPSED);
+  slot->timed = 1;
+}
+
+int setAntialiasing(Renderer *renderer, AntialiasingMode mode)
+{
+  int width = renderer->graph.width, height = renderer->graph.height;
+  renderer->settings.antialiasing = mode;
+  rgDestroy(&renderer->graph);
+  return buildRenderGraph(renderer, width, height);
+}
+
+const char *antialiasingName(AntialiasingMode mode)
+{
+  switch (mode)
+  {
+  case AA_NONE:
+    return "none";
+  case AA_MSAA:
+    return "msaa";
+  case AA_FXAA:
+    return "fxaa";
+  default:
+    return "?";
+  }
+}
+
+// accumulates one sample into the running sum, count and maximum
+static void addTiming(TimingStats *stats, double seconds)
+{
+  stats->sum += seconds;
+  stats->count++;
+  if (seconds > stats->max)
+    stats->max = seconds;
+}
+
+void resetTimingStats(TimingStats *stats)
+{
+  stats->sum = stats->max = 0.0;
+  stats->count = 0;
+}
+
+// the frame's fence has signaled, so the GPU has finished it and it is being presented
+static void retireFrame(Renderer *renderer, FrameSlot *slot)
+{
+  double now = glfwGetTime();
+  glDeleteSync(slot->fence);
+  slot->fence = 0;
+
+  // the query ended before the fence, its result is available without stalling
+  if (slot->timed)
+  {
+    GLuint64 elapsed = 0;
+    glGetQueryObjectui64v(slot->timer, GL_QUERY_RESULT, &elapsed);
+    addTiming(&renderer->gpuTime, elapsed * 1e-9);
+    slot->timed = 0;
+  }
+
+  if (slot->inputTime >= 0.0)
+    addTiming(&renderer->latency, now - slot->inputTime);
+}
+
+static void reportLatency(Renderer *renderer)
+{
+  TimingStats *stats = &renderer->latency;
+  double now = glfwGetTime();
+  if (now - stats->lastReport < LATENCY_REPORT_INTERVAL)
+    return;
+  if (stats->count > 0)
+    printf("input to present: avg %.1f ms, max %.1f ms over %d frames (%d in flight)\n",
+           stats->sum / stats->count * 1000.0, stats->max * 1000.0, stats->count, renderer->settings.framesInFlight);
+  resetTimingStats(stats);
+  stats->lastReport = now;
+}
+
+void beginFrame(Renderer *renderer)
+{
+  // retire whatever already finished so its latency is not measured late
+  for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+  {
+    FrameSlot *slot = &renderer->frameSlots[i];
+    if (slot->fence && glClientWaitSync(slot->fence, 0, 0) != GL_TIMEOUT_EXPIRED)
+      retireFrame(renderer, slot);
+  }
+
+  // the slot this frame reuses belongs to the frame framesInFlight frames ago
+  FrameSlot *slot = &renderer->frameSlots[renderer->frameIndex % renderer->settings.framesInFlight];
+  if (slot->fence)
+  {
+    GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+    while (glClientWaitSync(slot->fence, flags, 100000000) == GL_TIMEOUT_EXPIRED) // 100 ms
+      flags = 0;
+    retireFrame(renderer, slot);
+  }
+
+  if (renderer->settings.reportLatency)
+    reportLatency(renderer);
+}
+
+void endFrame(Renderer *renderer)
+{
+  FrameSlot *slot = &renderer->frameSlots[renderer->frameIndex % renderer->settings.framesInFlight];
+  slot->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  slot->inputTime = renderer->frame.inputTime;
+  renderer->frameIndex++;
+}
+
+void createProjectionMatrix(Renderer *renderer, float aspect, float *matrix)
+{
+  switch (renderer->settings.depthMode)
+  {
+  case DEPTH_REVERSED_Z:
+    create_reversed_perspective_matrix(RADIANS(CAMERA_FOV), aspect, WIDE_DEPTH_NEAR, matrix);
+    break;
+  case DEPTH_LOGARITHMIC:
+    // z is replaced in basic.vs, only x, y and w of this matrix are used
+    create_perspective_matrix(RADIANS(CAMERA_FOV), aspect, WIDE_DEPTH_NEAR, LOG_DEPTH_FAR, matrix);
+    break;
+  default:
+    create_perspective_matrix(RADIANS(CAMERA_FOV), aspect, CAMERA_NEAR, CAMERA_FAR, matrix);
+    break;
+  }
+}
+
+void cycleDebugView(Renderer *renderer)
+{
+  RenderGraph *graph = &renderer->graph;
+  int next = graph->debugView;
+  // skip depth targets, they cannot be blitted as color
+  do
+  {
+    next = (next + 1) % graph->resourceCount;
+    if (!rgIsDepthFormat(graph->resources[next].desc.format))
+      break;
+  } while (next != graph->debugView);
+
+  rgSetDebugView(graph, next);
+  printf("Debug view: %s\n", graph->resources[next].name);
+}
@@ -0,0 +1,192 @@
+#pragma once
+
+#include "billboardatlas.h"
+#include "mathematics.h"
+#include "meshes.h"
+#include "meshregistry.h"
+#include "rendergraph.h"
+
+#define MSAA_SAMPLES 4
+#define SPHERE_DETAIL 45 // default stacks and slices of the planet and atmosphere spheres
+
+// tessellation (GL 4.0)
+#define TESS_BASE_DETAIL 8     // stacks and slices of the base sphere the patches come from
+#define TESS_EDGE_PIXELS 12.0f // target screen length of a generated edge
+#define TESS_MAX_LEVEL 64.0f   // smallest GL_MAX_TESS_GEN_LEVEL an implementation may have
+
+// billboards
+#define BILLBOARD_MAX_PIXELS 64.0f // screen diameter of the atmosphere below which it is drawn from the atlas
+#define BILLBOARD_PLANET 0         // atlas body id of the planet and its atmosphere
+
+// projection
+#define CAMERA_FOV 45.0f
+#define CAMERA_NEAR 0.1f
+#define CAMERA_FAR 300.0f
+#define WIDE_DEPTH_NEAR 0.001f // near plane of the reversed-Z and logarithmic modes
+#define LOG_DEPTH_FAR 1.0e7f
+
+typedef enum
+{
+  DEPTH_STANDARD,   // [-1, 1] depth between CAMERA_NEAR and CAMERA_FAR
+  DEPTH_REVERSED_Z, // infinite reversed projection into a 32F buffer, needs glClipControl (GL 4.5)
+  DEPTH_LOGARITHMIC // GL 3.3 fallback, logarithmic depth written by the planet shader
+} DepthMode;
+
+// frame pacing
+#define MAX_FRAMES_IN_FLIGHT 4
+#define DEFAULT_FRAMES_IN_FLIGHT 3 // roughly what drivers queue on their own
+#define LATENCY_REPORT_INTERVAL 1.0 // seconds
+
+typedef enum
+{
+  AA_NONE,
+  AA_MSAA, // MSAA_SAMPLES per pixel for the planet, resolved before the atmosphere
+  AA_FXAA, // luminance edge filter after tone mapping, single-sample scene
+  AA_MODE_COUNT
+} AntialiasingMode;
+
+typedef struct
+{
+  DepthMode depthMode;
+  AntialiasingMode antialiasing;
+  int framesInFlight; // frames the CPU may run ahead of the GPU, 1 = lowest latency
+  int reportLatency;  // print input-to-present latency every LATENCY_REPORT_INTERVAL
+  VertexLayout vertexLayout;
+  int sphereDetail;      // stacks and slices of the sphere mesh, generated on a worker thread
+  int proceduralSpheres; // rebuild the spheres from gl_VertexID instead of storing vertices
+  int optimizeIndices;   // reorder sphere indices for the post-transform cache and overdraw
+  int triangleStrips;    // one strip per sphere stack joined by primitive restart
+  int tessellation;      // refine a coarse sphere on the GPU by screen-space edge length, needs GL 4.0
+  int impostorSpheres;   // ray trace each sphere inside a screen-aligned quad instead of rasterizing it
+  int billboards;        // draw small distant bodies from cached atlas tiles
+} RendererSettings;
+
+// automatic exposure
+#define LUMINANCE_SIZE 256             // log luminance is reduced from this power of two target
+#define EXPOSURE_KEY 0.18f             // middle grey the average luminance is exposed to
+#define EXPOSURE_MIN 0.05f
+#define EXPOSURE_MAX 20.0f
+#define EXPOSURE_ADAPTATION_RATE 1.5f // per second, higher adapts faster
+#define EXPOSURE_SETTLE_TIME (3.0f / EXPOSURE_ADAPTATION_RATE)
+
+// everything the passes need to draw one frame, filled in by the application
+typedef struct
+{
+  float model[16];
+  float view[16];
+  float projection[16];
+  float viewPos[3];
+  float lightPos[3];
+  float sunDirection[3];
+  float deltaTime; // seconds since the last rendered frame, drives exposure adaptation
+  int wireframe;
+  double inputTime; // glfwGetTime() of the oldest input applied to this frame, < 0 when none
+} FrameParams;
+
+// matrices derived from the frame's view and projection, rebuilt only when those change
+typedef struct
+{
+  float view[16];
+  float projection[16];
+  float viewProj[16];
+  unsigned int version; // bumped whenever viewProj changes, 0 = never built
+} CameraTransforms;
+
+// per draw matrices, rebuilt only when the model matrix or viewProj changes
+typedef struct
+{
+  float model[16];
+  float mvp[16];
+  float normalMatrix[9]; // column-major mat3
+  unsigned int cameraVersion; // CameraTransforms version mvp was built from
+} DrawTransforms;
+
+// a submitted frame the GPU may still be working on
+typedef struct
+{
+  GLsync fence;
+  double inputTime;
+  GLuint timer; // GL_TIME_ELAPSED of the frame's passes
+  int timed;
+} FrameSlot;
+
+typedef struct
+{
+  double sum, max; // seconds
+  int count;
+  double lastReport;
+} TimingStats;
+
+typedef struct
+{
+  RendererSettings settings; // as supported by the context
+
+  // shaders
+  unsigned int basicShader;
+  unsigned int atmosphereShader;
+  unsigned int luminanceShader;
+  unsigned int adaptationShader;
+  unsigned int tonemapShader;
+  unsigned int fxaaShader;
+  unsigned int billboardShader;
+  unsigned int tilePlanetShader; // impostors rendering the planet and atmosphere into atlas tiles
+  unsigned int tileAtmosphereShader;
+
+  // meshes
+  MeshRegistry meshes;
+  const Mesh *planetMesh; // unit spheres shared through the registry, scaled by the model matrix
+  const Mesh *atmosphereMesh;
+  float planetRadius;
+  float atmosphereRadius;
+  unsigned int emptyVao; // full screen passes generate their vertices
+
+  // distant bodies
+  BillboardAtlas billboards;
+  int billboardTile; // tile the planet is drawn from this frame, -1 = drawn as geometry
+
+  // exposure state carried between frames
+  GLuint adaptedLuminance;
+  int exposureValid;
+
+  // passes and the targets they share
+  RenderGraph graph;
+  int sceneColor; // multisampled HDR radiance of the planet
+  int sceneDepth;
+  int hdrColor;      // resolved radiance, the atmosphere is added at single-sample rate
+  int resolvedDepth; // read by the atmosphere to stop at opaque geometry
+  int ldrColor;      // tone mapped image when FXAA runs afterwards
+  int logLuminance;
+  int exposure;
+
+  FrameParams frame; // parameters of the frame currently being rendered
+  CameraTransforms camera;
+  DrawTransforms planetTransforms;
+  DrawTransforms atmosphereTransforms;
+
+  // frames in flight
+  FrameSlot frameSlots[MAX_FRAMES_IN_FLIGHT];
+  int frameIndex;
+  TimingStats latency;
+  TimingStats gpuTime;
+} Renderer;
+
+int initRenderer(Renderer *renderer, const RendererSettings *settings, float planetRadius, float atmosphereRadius, int width, int height);
+void destroyRenderer(Renderer *renderer);
+void resizeRenderer(Renderer *renderer, int width, int height);
+void renderFrame(Renderer *renderer, const FrameParams *frame);
+
+// waits until fewer than framesInFlight frames are queued, call before reading input for a frame
+void beginFrame(Renderer *renderer);
+// fences the frame, call right after glfwSwapBuffers
+void endFrame(Renderer *renderer);
+
+// projection matching the depth mode
+void createProjectionMatrix(Renderer *renderer, float aspect, float *matrix);
+
+// rebuilds the render graph for another antialiasing mode
+int setAntialiasing(Renderer *renderer, AntialiasingMode mode);
+const char *antialiasingName(AntialiasingMode mode);
+void resetTimingStats(TimingStats *stats);
+
+// shows the next intermediate graph resource instead of the final image
+void cycleDebugView(Renderer *renderer);
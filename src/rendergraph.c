@@ -0,0 +1,635 @@
+#include "rendergraph.h"
+
+int rgIsDepthFormat(GLenum format)
+{
+  return format == GL_DEPTH_COMPONENT16 || format == GL_DEPTH_COMPONENT24 || format == GL_DEPTH_COMPONENT32F ||
+         format == GL_DEPTH24_STENCIL8 || format == GL_DEPTH32F_STENCIL8;
+}
+
+// framebuffer attachment point of a depth format
+static GLenum depthAttachment(GLenum format)
+{
+  if (format == GL_DEPTH24_STENCIL8 || format == GL_DEPTH32F_STENCIL8)
+    return GL_DEPTH_STENCIL_ATTACHMENT;
+  return GL_DEPTH_ATTACHMENT;
+}
+
+// pixel transfer format matching a sized internal format, only used to allocate storage
+static void getTransferFormat(GLenum internalFormat, GLenum *format, GLenum *type)
+{
+  *type = GL_FLOAT;
+  switch (internalFormat)
+  {
+  case GL_DEPTH_COMPONENT16:
+  case GL_DEPTH_COMPONENT24:
+  case GL_DEPTH_COMPONENT32F:
+    *format = GL_DEPTH_COMPONENT;
+    break;
+  case GL_DEPTH24_STENCIL8:
+    *format = GL_DEPTH_STENCIL;
+    *type = GL_UNSIGNED_INT_24_8;
+    break;
+  case GL_DEPTH32F_STENCIL8:
+    *format = GL_DEPTH_STENCIL;
+    *type = GL_FLOAT_32_UNSIGNED_INT_24_8_REV;
+    break;
+  case GL_R8:
+  case GL_R16F:
+  case GL_R32F:
+    *format = GL_RED;
+    break;
+  case GL_RG8:
+  case GL_RG16F:
+  case GL_RG32F:
+    *format = GL_RG;
+    break;
+  case GL_RGB8:
+  case GL_RGB16F:
+  case GL_RGB32F:
+  case GL_R11F_G11F_B10F:
+    *format = GL_RGB;
+    break;
+  default:
+    *format = GL_RGBA;
+    break;
+  }
+}
+
+static int bytesPerPixel(GLenum format)
+{
+  switch (format)
+  {
+  case GL_R8:
+    return 1;
+  case GL_R16F:
+  case GL_RG8:
+  case GL_DEPTH_COMPONENT16:
+    return 2;
+  case GL_RGB8:
+    return 3;
+  case GL_RGBA16F:
+  case GL_RG32F:
+  case GL_DEPTH32F_STENCIL8:
+    return 8;
+  case GL_RGB16F:
+    return 6;
+  case GL_RGB32F:
+    return 12;
+  case GL_RGBA32F:
+    return 16;
+  default:
+    return 4;
+  }
+}
+
+void rgInit(RenderGraph *graph, int width, int height)
+{
+  memset(graph, 0, sizeof(*graph));
+  graph->width = width;
+  graph->height = height;
+
+  // resource 0 is always the default framebuffer
+  RGResource *backbuffer = &graph->resources[0];
+  strncpy(backbuffer->name, "backbuffer", sizeof(backbuffer->name) - 1);
+  backbuffer->imported = 1;
+  backbuffer->desc.format = GL_RGBA8;
+  graph->resourceCount = 1;
+  graph->debugView = RG_BACKBUFFER;
+}
+
+// frees pooled textures and pass framebuffers, keeps the declared passes and resources
+static void releaseTargets(RenderGraph *graph)
+{
+  for (int i = 0; i < graph->poolCount; i++)
+    glDeleteTextures(1, &graph->pool[i].texture);
+  graph->poolCount = 0;
+
+  for (int i = 0; i < graph->passCount; i++)
+  {
+    if (graph->passes[i].fbo)
+      glDeleteFramebuffers(1, &graph->passes[i].fbo);
+    graph->passes[i].fbo = 0;
+  }
+
+  for (int i = 0; i < graph->resourceCount; i++)
+  {
+    if (!graph->resources[i].imported)
+      graph->resources[i].handle = 0;
+  }
+  graph->compiled = 0;
+}
+
+void rgDestroy(RenderGraph *graph)
+{
+  releaseTargets(graph);
+  if (graph->blitFbo)
+    glDeleteFramebuffers(1, &graph->blitFbo);
+  graph->blitFbo = 0;
+}
+
+int rgCreateTexture(RenderGraph *graph, const char *name, RGTextureDesc desc)
+{
+  if (graph->resourceCount >= RG_MAX_RESOURCES)
+  {
+    fprintf(stderr, "Render graph resource limit reached, cannot add %s\n", name);
+    return -1;
+  }
+  RGResource *resource = &graph->resources[graph->resourceCount];
+  memset(resource, 0, sizeof(*resource));
+  strncpy(resource->name, name, sizeof(resource->name) - 1);
+  if (desc.scale <= 0.0f)
+    desc.scale = 1.0f;
+  resource->desc = desc;
+  graph->compiled = 0;
+  return graph->resourceCount++;
+}
+
+int rgImportTexture(RenderGraph *graph, const char *name, GLuint texture, int width, int height, GLenum format)
+{
+  RGTextureDesc desc = {.format = format, .scale = 1.0f, .width = width, .height = height};
+  int id = rgCreateTexture(graph, name, desc);
+  if (id < 0)
+    return id;
+  graph->resources[id].imported = 1;
+  graph->resources[id].handle = texture;
+  graph->resources[id].width = width;
+  graph->resources[id].height = height;
+  return id;
+}
+
+int rgAddPass(RenderGraph *graph, const char *name, RGExecuteFunc execute, void *userData)
+{
+  if (graph->passCount >= RG_MAX_PASSES)
+  {
+    fprintf(stderr, "Render graph pass limit reached, cannot add %s\n", name);
+    return -1;
+  }
+  RGPass *pass = &graph->passes[graph->passCount];
+  memset(pass, 0, sizeof(*pass));
+  strncpy(pass->name, name, sizeof(pass->name) - 1);
+  pass->execute = execute;
+  pass->userData = userData;
+  graph->compiled = 0;
+  return graph->passCount++;
+}
+
+void rgRead(RenderGraph *graph, int pass, int resource)
+{
+  RGPass *p = &graph->passes[pass];
+  if (p->readCount < RG_MAX_PASS_IO)
+    p->reads[p->readCount++] = resource;
+  graph->compiled = 0;
+}
+
+void rgWrite(RenderGraph *graph, int pass, int resource)
+{
+  RGPass *p = &graph->passes[pass];
+  if (p->writeCount < RG_MAX_PASS_IO)
+    p->writes[p->writeCount++] = resource;
+  graph->compiled = 0;
+}
+
+static int passReads(RGPass *pass, int resource)
+{
+  for (int i = 0; i < pass->readCount; i++)
+    if (pass->reads[i] == resource)
+      return 1;
+  return 0;
+}
+
+static int passWrites(RGPass *pass, int resource)
+{
+  for (int i = 0; i < pass->writeCount; i++)
+    if (pass->writes[i] == resource)
+      return 1;
+  return 0;
+}
+
+static void resolveSize(RenderGraph *graph, RGResource *resource)
+{
+  if (resource == &graph->resources[RG_BACKBUFFER])
+  {
+    resource->width = graph->width;
+    resource->height = graph->height;
+  }
+  else if (!resource->imported)
+  {
+    RGTextureDesc *desc = &resource->desc;
+    resource->width = desc->width > 0 ? desc->width : (int)(graph->width * desc->scale);
+    resource->height = desc->height > 0 ? desc->height : (int)(graph->height * desc->scale);
+    if (resource->width < 1)
+      resource->width = 1;
+    if (resource->height < 1)
+      resource->height = 1;
+  }
+}
+
+// finds a free pooled texture with a matching layout or allocates a new one
+static GLuint acquireTarget(RenderGraph *graph, RGResource *resource, int position)
+{
+  RGTextureDesc *desc = &resource->desc;
+  int samples = desc->samples > 1 ? desc->samples : 0;
+  for (int i = 0; i < graph->poolCount; i++)
+  {
+    RGTarget *target = &graph->pool[i];
+    if (target->freeAfter < position && target->format == desc->format && target->width == resource->width &&
+        target->height == resource->height && target->samples == samples && target->mipmaps == desc->mipmaps)
+    {
+      target->freeAfter = resource->lastUse;
+      return target->texture;
+    }
+  }
+
+  if (graph->poolCount >= RG_MAX_TARGETS)
+  {
+    fprintf(stderr, "Render graph target pool exhausted for %s\n", resource->name);
+    return 0;
+  }
+
+  RGTarget *target = &graph->pool[graph->poolCount++];
+  target->format = desc->format;
+  target->width = resource->width;
+  target->height = resource->height;
+  target->samples = samples;
+  target->mipmaps = desc->mipmaps;
+  target->freeAfter = resource->lastUse;
+
+  glGenTextures(1, &target->texture);
+  if (samples)
+  {
+    glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, target->texture);
+    glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, samples, desc->format, target->width, target->height, GL_TRUE);
+    glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, 0);
+  }
+  else
+  {
+    GLenum format, type;
+    getTransferFormat(desc->format, &format, &type);
+    glBindTexture(GL_TEXTURE_2D, target->texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, desc->format, target->width, target->height, 0, format, type, NULL);
+    GLenum filter = rgIsDepthFormat(desc->format) ? GL_NEAREST : GL_LINEAR;
+    if (desc->mipmaps)
+    {
+      // allocates the chain, the pass writing the texture regenerates it
+      glGenerateMipmap(GL_TEXTURE_2D);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_NEAREST);
+    }
+    else
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+  }
+  return target->texture;
+}
+
+static void createPassFramebuffer(RenderGraph *graph, RGPass *pass)
+{
+  if (pass->writeCount == 0 || passWrites(pass, RG_BACKBUFFER))
+  {
+    if (pass->writeCount > 1 && passWrites(pass, RG_BACKBUFFER))
+      fprintf(stderr, "Pass %s writes the backbuffer together with other targets\n", pass->name);
+    pass->fbo = 0;
+    return;
+  }
+
+  glGenFramebuffers(1, &pass->fbo);
+  glBindFramebuffer(GL_FRAMEBUFFER, pass->fbo);
+  GLenum drawBuffers[RG_MAX_PASS_IO];
+  int colorCount = 0;
+  for (int i = 0; i < pass->writeCount; i++)
+  {
+    RGResource *resource = &graph->resources[pass->writes[i]];
+    GLenum format = resource->desc.format;
+    GLenum attachment;
+    if (rgIsDepthFormat(format))
+      attachment = depthAttachment(format);
+    else
+    {
+      attachment = GL_COLOR_ATTACHMENT0 + colorCount;
+      drawBuffers[colorCount++] = attachment;
+    }
+    glFramebufferTexture(GL_FRAMEBUFFER, attachment, resource->handle, 0);
+  }
+  if (colorCount)
+    glDrawBuffers(colorCount, drawBuffers);
+  else
+    glDrawBuffer(GL_NONE);
+
+  if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    fprintf(stderr, "Framebuffer of pass %s is incomplete\n", pass->name);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+int rgCompile(RenderGraph *graph)
+{
+  releaseTargets(graph);
+  int count = graph->passCount;
+
+  // order[b][a]: a has to run before b, data[b][a]: b consumes what a produced
+  char order[RG_MAX_PASSES][RG_MAX_PASSES] = {{0}};
+  char data[RG_MAX_PASSES][RG_MAX_PASSES] = {{0}};
+  for (int b = 0; b < count; b++)
+  {
+    RGPass *pb = &graph->passes[b];
+    for (int a = 0; a < count; a++)
+    {
+      if (a == b)
+        continue;
+      RGPass *pa = &graph->passes[a];
+      for (int i = 0; i < pa->writeCount; i++)
+      {
+        int r = pa->writes[i];
+        // writes are read-modify-write (blending, accumulation) and keep declaration order
+        if (passWrites(pb, r) && a < b)
+          order[b][a] = data[b][a] = 1;
+        if (passReads(pb, r))
+        {
+          // readers see the latest earlier writer, or the first writer when it is declared later
+          int producer = -1;
+          for (int w = 0; w < count; w++)
+          {
+            if (w != b && passWrites(&graph->passes[w], r) && (w < b || producer < 0))
+              producer = w;
+          }
+          if (producer == a)
+            order[b][a] = data[b][a] = 1;
+        }
+      }
+      // a reader declared earlier has to finish before the resource is overwritten
+      for (int i = 0; i < pa->readCount; i++)
+      {
+        if (passWrites(pb, pa->reads[i]) && a < b && !order[a][b])
+          order[b][a] = 1;
+      }
+    }
+  }
+
+  // cull: keep passes that reach the backbuffer, an imported texture, the debug view or have side effects
+  char needed[RG_MAX_PASSES] = {0};
+  int stack[RG_MAX_PASSES];
+  int top = 0;
+  for (int p = 0; p < count; p++)
+  {
+    RGPass *pass = &graph->passes[p];
+    int root = pass->sideEffect;
+    for (int i = 0; i < pass->writeCount; i++)
+    {
+      int r = pass->writes[i];
+      if (graph->resources[r].imported || (graph->debugView != RG_BACKBUFFER && r == graph->debugView))
+        root = 1;
+    }
+    if (root)
+    {
+      needed[p] = 1;
+      stack[top++] = p;
+    }
+  }
+  while (top > 0)
+  {
+    int b = stack[--top];
+    for (int a = 0; a < count; a++)
+    {
+      if (data[b][a] && !needed[a])
+      {
+        needed[a] = 1;
+        stack[top++] = a;
+      }
+    }
+  }
+
+  // topological sort, declaration order breaks ties
+  char done[RG_MAX_PASSES] = {0};
+  graph->orderCount = 0;
+  for (int p = 0; p < count; p++)
+    graph->passes[p].culled = !needed[p];
+  for (int emitted = 1; emitted;)
+  {
+    emitted = 0;
+    for (int b = 0; b < count; b++)
+    {
+      if (done[b] || !needed[b])
+        continue;
+      int ready = 1;
+      for (int a = 0; a < count; a++)
+      {
+        if (order[b][a] && needed[a] && !done[a])
+          ready = 0;
+      }
+      if (ready)
+      {
+        done[b] = 1;
+        graph->order[graph->orderCount++] = b;
+        emitted = 1;
+        break;
+      }
+    }
+  }
+  for (int p = 0; p < count; p++)
+  {
+    if (needed[p] && !done[p])
+    {
+      fprintf(stderr, "Render graph has a dependency cycle at pass %s\n", graph->passes[p].name);
+      return 0;
+    }
+  }
+
+  // lifetimes in execution order
+  for (int r = 0; r < graph->resourceCount; r++)
+  {
+    graph->resources[r].firstUse = -1;
+    graph->resources[r].lastUse = -1;
+    resolveSize(graph, &graph->resources[r]);
+  }
+  for (int position = 0; position < graph->orderCount; position++)
+  {
+    RGPass *pass = &graph->passes[graph->order[position]];
+    for (int i = 0; i < pass->readCount + pass->writeCount; i++)
+    {
+      int r = i < pass->readCount ? pass->reads[i] : pass->writes[i - pass->readCount];
+      RGResource *resource = &graph->resources[r];
+      if (resource->firstUse < 0)
+        resource->firstUse = position;
+      resource->lastUse = position;
+    }
+  }
+  if (graph->debugView != RG_BACKBUFFER && graph->resources[graph->debugView].firstUse >= 0)
+    graph->resources[graph->debugView].lastUse = graph->orderCount;
+
+  // alias transient textures whose lifetimes do not overlap
+  for (int position = 0; position < graph->orderCount; position++)
+  {
+    for (int r = 0; r < graph->resourceCount; r++)
+    {
+      RGResource *resource = &graph->resources[r];
+      if (!resource->imported && resource->firstUse == position)
+        resource->handle = acquireTarget(graph, resource, position);
+    }
+  }
+
+  for (int position = 0; position < graph->orderCount; position++)
+    createPassFramebuffer(graph, &graph->passes[graph->order[position]]);
+
+  graph->compiled = 1;
+  return 1;
+}
+
+void rgResize(RenderGraph *graph, int width, int height)
+{
+  if (graph->width == width && graph->height == height)
+    return;
+  graph->width = width;
+  graph->height = height;
+  graph->compiled = 0;
+}
+
+void rgExecute(RenderGraph *graph)
+{
+  if (!graph->compiled && !rgCompile(graph))
+    return;
+
+  for (int position = 0; position < graph->orderCount; position++)
+  {
+    RGPass *pass = &graph->passes[graph->order[position]];
+    int width = graph->width, height = graph->height;
+    if (pass->writeCount > 0)
+      rgGetSize(graph, pass->writes[0], &width, &height);
+    graph->currentPass = graph->order[position];
+    glBindFramebuffer(GL_FRAMEBUFFER, pass->fbo);
+    glViewport(0, 0, width, height);
+    pass->execute(graph, pass->userData);
+  }
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  glViewport(0, 0, graph->width, graph->height);
+
+  if (graph->debugView != RG_BACKBUFFER)
+    rgBlitToBackbuffer(graph, graph->debugView);
+}
+
+GLuint rgGetTexture(RenderGraph *graph, int resource)
+{
+  return graph->resources[resource].handle;
+}
+
+void rgGetSize(RenderGraph *graph, int resource, int *width, int *height)
+{
+  if (resource == RG_BACKBUFFER)
+  {
+    *width = graph->width;
+    *height = graph->height;
+    return;
+  }
+  *width = graph->resources[resource].width;
+  *height = graph->resources[resource].height;
+}
+
+// copies (and resolves, for multisample textures) a color resource into a framebuffer
+static void blitResource(RenderGraph *graph, int resource, GLuint drawFbo, int width, int height)
+{
+  RGResource *source = &graph->resources[resource];
+  if (resource == RG_BACKBUFFER || !source->handle)
+    return;
+  // depth is only copied between graph targets, the window's depth format is unknown
+  int depth = rgIsDepthFormat(source->desc.format);
+  if (depth && (drawFbo == 0 || source->width != width || source->height != height))
+    return;
+
+  if (!graph->blitFbo)
+    glGenFramebuffers(1, &graph->blitFbo);
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, graph->blitFbo);
+  // one attachment at a time, leftovers with another sample count would make it incomplete
+  glFramebufferTexture(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, depth ? 0 : source->handle, 0);
+  glFramebufferTexture(GL_READ_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, 0, 0);
+  glFramebufferTexture(GL_READ_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, 0, 0);
+  if (depth)
+    glFramebufferTexture(GL_READ_FRAMEBUFFER, depthAttachment(source->desc.format), source->handle, 0);
+  glReadBuffer(depth ? GL_NONE : GL_COLOR_ATTACHMENT0);
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, drawFbo);
+
+  int sameSize = source->width == width && source->height == height;
+  glBlitFramebuffer(0, 0, source->width, source->height, 0, 0, width, height,
+                    depth ? GL_DEPTH_BUFFER_BIT : GL_COLOR_BUFFER_BIT,
+                    sameSize || source->desc.samples > 1 ? GL_NEAREST : GL_LINEAR);
+  glBindFramebuffer(GL_FRAMEBUFFER, drawFbo);
+}
+
+void rgBlitToBackbuffer(RenderGraph *graph, int resource)
+{
+  blitResource(graph, resource, 0, graph->width, graph->height);
+}
+
+void rgBlitToTarget(RenderGraph *graph, int resource)
+{
+  RGPass *pass = &graph->passes[graph->currentPass];
+  int width = graph->width, height = graph->height;
+  if (pass->writeCount > 0)
+    rgGetSize(graph, pass->writes[0], &width, &height);
+  blitResource(graph, resource, pass->fbo, width, height);
+}
+
+void rgSetDebugView(RenderGraph *graph, int resource)
+{
+  if (resource < 0 || resource >= graph->resourceCount)
+    resource = RG_BACKBUFFER;
+  if (rgIsDepthFormat(graph->resources[resource].desc.format))
+  {
+    fprintf(stderr, "Depth resource %s cannot be shown as a debug view\n", graph->resources[resource].name);
+    return;
+  }
+  if (graph->debugView != resource)
+  {
+    graph->debugView = resource;
+    graph->compiled = 0;
+  }
+}
+
+int rgFindResource(RenderGraph *graph, const char *name)
+{
+  for (int i = 0; i < graph->resourceCount; i++)
+  {
+    if (strcmp(graph->resources[i].name, name) == 0)
+      return i;
+  }
+  return -1;
+}
+
+void rgPrint(RenderGraph *graph)
+{
+  if (!graph->compiled)
+    rgCompile(graph);
+
+  printf("Render graph %dx%d\n", graph->width, graph->height);
+  for (int position = 0; position < graph->orderCount; position++)
+  {
+    RGPass *pass = &graph->passes[graph->order[position]];
+    printf("  %d: %s\n", position, pass->name);
+  }
+  for (int p = 0; p < graph->passCount; p++)
+  {
+    if (graph->passes[p].culled)
+      printf("  culled: %s\n", graph->passes[p].name);
+  }
+
+  long pooled = 0, unaliased = 0;
+  for (int i = 0; i < graph->poolCount; i++)
+  {
+    RGTarget *target = &graph->pool[i];
+    int samples = target->samples > 1 ? target->samples : 1;
+    long bytes = (long)target->width * target->height * bytesPerPixel(target->format) * samples;
+    pooled += target->mipmaps ? bytes * 4 / 3 : bytes;
+  }
+  for (int r = 1; r < graph->resourceCount; r++)
+  {
+    RGResource *resource = &graph->resources[r];
+    if (resource->imported || resource->firstUse < 0)
+      continue;
+    int samples = resource->desc.samples > 1 ? resource->desc.samples : 1;
+    long bytes = (long)resource->width * resource->height * bytesPerPixel(resource->desc.format) * samples;
+    unaliased += resource->desc.mipmaps ? bytes * 4 / 3 : bytes;
+    printf("  %-16s %4dx%-4d passes %d-%d texture %u\n", resource->name, resource->width, resource->height,
+           resource->firstUse, resource->lastUse, resource->handle);
+  }
+  printf("  %d pooled textures, %.1f MB (%.1f MB without aliasing)\n", graph->poolCount, pooled / 1048576.0,
+         unaliased / 1048576.0);
+}
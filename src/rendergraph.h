@@ -0,0 +1,103 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <stdio.h>
+#include <string.h>
+
+#define RG_MAX_PASSES 32
+#define RG_MAX_RESOURCES 32
+#define RG_MAX_PASS_IO 8
+#define RG_MAX_TARGETS 32
+
+// resource id of the default framebuffer
+#define RG_BACKBUFFER 0
+
+typedef struct RenderGraph RenderGraph;
+typedef void (*RGExecuteFunc)(RenderGraph *graph, void *userData);
+
+// description of a transient texture, sized relative to the backbuffer unless width/height are set
+typedef struct
+{
+  GLenum format; // sized internal format e.g. GL_RGBA16F, GL_DEPTH_COMPONENT24
+  float scale;   // 1.0 = full resolution, 0.5 = half resolution
+  int width;     // fixed size (LUTs), overrides scale when > 0
+  int height;
+  int samples; // > 1 allocates a multisample texture
+  int mipmaps; // allocates a full mip chain, e.g. for reductions with glGenerateMipmap
+} RGTextureDesc;
+
+typedef struct
+{
+  char name[32];
+  RGTextureDesc desc;
+  int imported;  // owned outside the graph, never aliased or culled
+  GLuint handle; // imported texture, or the pooled texture assigned by rgCompile
+  int width, height;
+  int firstUse, lastUse; // execution order range, -1 when unused
+} RGResource;
+
+typedef struct
+{
+  char name[32];
+  RGExecuteFunc execute;
+  void *userData;
+  int reads[RG_MAX_PASS_IO];
+  int readCount;
+  int writes[RG_MAX_PASS_IO];
+  int writeCount;
+  int sideEffect; // never culled (e.g. writes persistent state through its own means)
+  int culled;
+  GLuint fbo;
+} RGPass;
+
+// physical texture in the transient pool
+typedef struct
+{
+  GLuint texture;
+  GLenum format;
+  int width, height, samples, mipmaps;
+  int freeAfter; // last pass index of the current owner
+} RGTarget;
+
+struct RenderGraph
+{
+  RGPass passes[RG_MAX_PASSES];
+  int passCount;
+  RGResource resources[RG_MAX_RESOURCES];
+  int resourceCount;
+  int order[RG_MAX_PASSES]; // pass indices in execution order, culled passes removed
+  int orderCount;
+  RGTarget pool[RG_MAX_TARGETS];
+  int poolCount;
+  int width, height; // backbuffer size
+  int debugView;     // resource blitted to the backbuffer after execution, RG_BACKBUFFER = off
+  int compiled;
+  int currentPass; // pass being executed
+  GLuint blitFbo;
+};
+
+// setup
+void rgInit(RenderGraph *graph, int width, int height);
+void rgDestroy(RenderGraph *graph);
+int rgCreateTexture(RenderGraph *graph, const char *name, RGTextureDesc desc);
+int rgImportTexture(RenderGraph *graph, const char *name, GLuint texture, int width, int height, GLenum format);
+int rgAddPass(RenderGraph *graph, const char *name, RGExecuteFunc execute, void *userData);
+void rgRead(RenderGraph *graph, int pass, int resource);
+void rgWrite(RenderGraph *graph, int pass, int resource);
+
+// orders passes, culls the ones whose outputs are never used and assigns pooled textures
+int rgCompile(RenderGraph *graph);
+void rgResize(RenderGraph *graph, int width, int height);
+void rgExecute(RenderGraph *graph);
+
+// access from inside a pass
+GLuint rgGetTexture(RenderGraph *graph, int resource);
+void rgGetSize(RenderGraph *graph, int resource, int *width, int *height);
+void rgBlitToBackbuffer(RenderGraph *graph, int resource);
+void rgBlitToTarget(RenderGraph *graph, int resource); // into the framebuffer of the executing pass, resolves MSAA color and depth
+
+// debugging
+int rgIsDepthFormat(GLenum format);
+void rgSetDebugView(RenderGraph *graph, int resource);
+int rgFindResource(RenderGraph *graph, const char *name);
+void rgPrint(RenderGraph *graph);
@@ -0,0 +1,12 @@
+#version 330 core
+
+uniform sampler2D logLuminance;  // mipmapped log luminance
+uniform float topLevel;          // 1x1 mip level holding the average
+
+out vec4 FragColor;
+
+void main() {
+    float averageLog = textureLod(logLuminance, vec2(0.5), topLevel).r;
+    // blended over last frame's value with a constant alpha for temporal adaptation
+    FragColor = vec4(exp(averageLog), 0.0, 0.0, 1.0);
+}
@@ -1,16 +1,60 @@
 #version 330 core
+#ifdef PROCEDURAL_SPHERE
+#define SPHERE_NORMALS
+vec3 aPos;
+#else
 layout (location = 0) in vec3 aPos;
+#endif
+#if defined(SPHERE_NORMALS)
+// positions on a sphere around the origin are their own normals
+#elif defined(OCTAHEDRAL_NORMALS)
+layout (location = 1) in vec2 aNormal;
+#else
 layout (location = 1) in vec3 aNormal;
+#endif
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+uniform mat4 mvp;          // projection * view * model, built once per draw on the CPU
+uniform mat3 normalMatrix; // transpose(inverse(mat3(model))), likewise
 
 out vec3 FragPos;
 out vec3 Normal;
 
+#ifdef LOG_DEPTH
+uniform float logDepthCoef; // 2.0 / log2(far + 1.0)
+out float flogz;
+#endif
+
+#ifdef PROCEDURAL_SPHERE
+#include "proceduralsphere.glsl"
+#endif
+
+#ifdef OCTAHEDRAL_NORMALS
+vec3 decodeOctahedral(vec2 e) {
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0); // unfold the lower hemisphere
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+#endif
+
 void main() {
+#ifdef PROCEDURAL_SPHERE
+    aPos = proceduralSpherePosition();
+#endif
     FragPos = vec3(model * vec4(aPos, 1.0));
-    Normal = mat3(transpose(inverse(model))) * aNormal;
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+#if defined(SPHERE_NORMALS)
+    Normal = normalMatrix * aPos; // normalized in phong.fs
+#elif defined(OCTAHEDRAL_NORMALS)
+    Normal = normalMatrix * decodeOctahedral(aNormal);
+#else
+    Normal = normalMatrix * aNormal;
+#endif
+    gl_Position = mvp * vec4(aPos, 1.0);
+#ifdef LOG_DEPTH
+    // logarithmic depth for contexts without glClipControl, corrected per fragment in phong.fs
+    gl_Position.z = (log2(max(1e-6, 1.0 + gl_Position.w)) * logDepthCoef - 1.0) * gl_Position.w;
+    flogz = 1.0 + gl_Position.w;
+#endif
 }
@@ -0,0 +1,17 @@
+#version 330 core
+// distant body drawn from its billboard atlas tile, premultiplied HDR radiance with the
+// planet's coverage in alpha
+
+in vec2 tileCoord; // impostor.vs
+
+uniform sampler2D atlas;
+uniform vec2 tileOffset; // lower left corner of the tile in the atlas
+uniform float tileScale; // size of a tile in the atlas
+
+out vec4 FragColor;
+
+void main() {
+    // half a texel in from the tile's border so filtering never reaches into the neighbours
+    vec2 inset = 0.5 / (vec2(textureSize(atlas, 0)) * tileScale);
+    FragColor = texture(atlas, tileOffset + clamp(tileCoord, inset, 1.0 - inset) * tileScale);
+}
@@ -26,7 +26,33 @@ uniform float mHeight;      // Mie scale height
 uniform float g;        // Mie scattering direction - 
                         //  - anisotropy of the medium
 
-uniform float toneMappingFactor;    ///< Whether tone mapping is applied
+// resolved depth of the opaque scene
+uniform sampler2D sceneDepth;
+uniform int depthMode;    // DepthMode in renderer.h: 0 standard, 1 reversed-Z, 2 logarithmic
+uniform vec2 depthRange;  // near and far plane of the projection
+uniform vec3 viewForward; // camera axis in world space
+
+/**
+ * @brief Converts a depth buffer value back to the view space depth
+ * @param d Depth buffer value
+ * @return Distance along the camera axis, -1 where nothing was drawn
+ */
+float linearDepth(float d)
+{
+    float near = depthRange.x;
+    float far = depthRange.y;
+    if (depthMode == 1) {
+        return d <= 0.0 ? -1.0 : near / d;
+    }
+    if (d >= 1.0) {
+        return -1.0;
+    }
+    if (depthMode == 2) {
+        return exp2(d * log2(far + 1.0)) - 1.0;
+    }
+    float ndc = d * 2.0 - 1.0;
+    return 2.0 * near * far / (far + near - ndc * (far - near));
+}
 
 /**
  * @brief Computes intersection between a ray and a sphere
@@ -78,10 +104,18 @@ vec3 computeSkyColor(vec3 ray, vec3 origin)
 
     // Distance between samples - length of each segment
     t.y = min(t.y, raySphereIntersection(origin, ray, planetRadius).x);
-    float segmentLen = (t.y - t.x) / float(viewSamples);
-
-    // TODO t min
-    float tCurrent = 0.0f; 
+#ifndef NO_SCENE_DEPTH
+    float sceneDistance = linearDepth(texelFetch(sceneDepth, ivec2(gl_FragCoord.xy), 0).r);
+    if (sceneDistance > 0.0) {
+        t.y = min(t.y, sceneDistance / dot(ray, viewForward));
+    }
+#endif
+    // start where the ray enters the atmosphere, or at the viewer when inside it
+    float tCurrent = max(t.x, 0.0);
+    if (t.y <= tCurrent) {
+        return vec3(0.0, 0.0, 0.0);
+    }
+    float segmentLen = (t.y - tCurrent) / float(viewSamples);
 
     // Rayleigh and Mie contribution
     vec3 sum_R = vec3(0);
@@ -164,10 +198,8 @@ vec3 computeSkyColor(vec3 ray, vec3 origin)
 
 void main()
 {
+    // linear radiance, exposure and tone mapping happen in tonemap.fs
     vec3 acolor = computeSkyColor(normalize(fragPos - viewPos), viewPos);
 
-    // Apply tone mapping
-    acolor = mix(acolor, (1.0 - exp(-1.0 * acolor)), toneMappingFactor);
-
     FragColor = vec4(acolor, 1.0);
 }
\ No newline at end of file
@@ -1,16 +1,26 @@
 #version 330 core
 
+#ifdef PROCEDURAL_SPHERE
+vec3 aPos;
+#else
 layout(location = 0) in vec3 aPos;  // Position of the vertex
+#endif
 
 uniform mat4 model;         // Model matrix for the atmosphere sphere
-uniform mat4 view;          // View matrix
-uniform mat4 projection;    // Projection matrix
+uniform mat4 mvp;           // projection * view * model
 
 out vec3 fragPos;           // Position of the fragment in world space
 
+#ifdef PROCEDURAL_SPHERE
+#include "proceduralsphere.glsl"
+#endif
+
 void main() {
+#ifdef PROCEDURAL_SPHERE
+    aPos = proceduralSpherePosition();
+#endif
     // Calculate the position of the vertex in world space
     fragPos = vec3(model * vec4(aPos, 1.0));
     // Final position in clip space
-    gl_Position = projection * view * vec4(fragPos, 1.0);
+    gl_Position = mvp * vec4(aPos, 1.0);
 }
@@ -0,0 +1,126 @@
+#version 330 core
+
+in vec2 texCoord;
+
+uniform sampler2D ldrColor; // tone mapped image, sampled with linear filtering
+uniform vec2 texelSize;     // 1 / resolution
+
+out vec4 FragColor;
+
+#define EDGE_THRESHOLD 0.166      // contrast relative to the brightest neighbour that counts as an edge
+#define EDGE_THRESHOLD_MIN 0.0312 // dark regions are left alone
+#define SUBPIXEL_QUALITY 0.75
+#define SEARCH_STEPS 12
+
+// step sizes along the edge, growing once the first texels did not find its end
+const float searchStep[SEARCH_STEPS] = float[](1.0, 1.0, 1.0, 1.0, 1.0, 1.5, 2.0, 2.0, 2.0, 2.0, 4.0, 8.0);
+
+float luma(vec3 color)
+{
+    return sqrt(dot(color, vec3(0.299, 0.587, 0.114)));
+}
+
+float lumaAt(vec2 uv)
+{
+    return luma(textureLod(ldrColor, uv, 0.0).rgb);
+}
+
+void main()
+{
+    vec3 colorCenter = textureLod(ldrColor, texCoord, 0.0).rgb;
+    float lumaCenter = luma(colorCenter);
+    float lumaS = luma(textureLodOffset(ldrColor, texCoord, 0.0, ivec2(0, -1)).rgb);
+    float lumaN = luma(textureLodOffset(ldrColor, texCoord, 0.0, ivec2(0, 1)).rgb);
+    float lumaW = luma(textureLodOffset(ldrColor, texCoord, 0.0, ivec2(-1, 0)).rgb);
+    float lumaE = luma(textureLodOffset(ldrColor, texCoord, 0.0, ivec2(1, 0)).rgb);
+
+    // local contrast, most pixels stop here
+    float lumaMin = min(lumaCenter, min(min(lumaS, lumaN), min(lumaW, lumaE)));
+    float lumaMax = max(lumaCenter, max(max(lumaS, lumaN), max(lumaW, lumaE)));
+    float lumaRange = lumaMax - lumaMin;
+    if (lumaRange < max(EDGE_THRESHOLD_MIN, lumaMax * EDGE_THRESHOLD)) {
+        FragColor = vec4(colorCenter, 1.0);
+        return;
+    }
+
+    float lumaSW = luma(textureLodOffset(ldrColor, texCoord, 0.0, ivec2(-1, -1)).rgb);
+    float lumaNE = luma(textureLodOffset(ldrColor, texCoord, 0.0, ivec2(1, 1)).rgb);
+    float lumaNW = luma(textureLodOffset(ldrColor, texCoord, 0.0, ivec2(-1, 1)).rgb);
+    float lumaSE = luma(textureLodOffset(ldrColor, texCoord, 0.0, ivec2(1, -1)).rgb);
+
+    // orientation of the edge from the 3x3 neighbourhood
+    float edgeHorizontal = abs(lumaNW - 2.0 * lumaW + lumaSW) + 2.0 * abs(lumaN - 2.0 * lumaCenter + lumaS) +
+                           abs(lumaNE - 2.0 * lumaE + lumaSE);
+    float edgeVertical = abs(lumaNW - 2.0 * lumaN + lumaNE) + 2.0 * abs(lumaW - 2.0 * lumaCenter + lumaE) +
+                         abs(lumaSW - 2.0 * lumaS + lumaSE);
+    bool horizontal = edgeHorizontal >= edgeVertical;
+
+    // which side of the pixel the edge lies on
+    float luma1 = horizontal ? lumaS : lumaW;
+    float luma2 = horizontal ? lumaN : lumaE;
+    float gradient1 = luma1 - lumaCenter;
+    float gradient2 = luma2 - lumaCenter;
+    bool steepest1 = abs(gradient1) >= abs(gradient2);
+    float gradientScaled = 0.25 * max(abs(gradient1), abs(gradient2));
+
+    float stepLength = horizontal ? texelSize.y : texelSize.x;
+    float lumaLocalAverage;
+    if (steepest1) {
+        stepLength = -stepLength;
+        lumaLocalAverage = 0.5 * (luma1 + lumaCenter);
+    } else {
+        lumaLocalAverage = 0.5 * (luma2 + lumaCenter);
+    }
+
+    // walk along the edge in both directions until the contrast ends
+    vec2 edgeUv = texCoord;
+    if (horizontal) {
+        edgeUv.y += stepLength * 0.5;
+    } else {
+        edgeUv.x += stepLength * 0.5;
+    }
+    vec2 offset = horizontal ? vec2(texelSize.x, 0.0) : vec2(0.0, texelSize.y);
+    vec2 uv1 = edgeUv - offset;
+    vec2 uv2 = edgeUv + offset;
+    float lumaEnd1 = lumaAt(uv1) - lumaLocalAverage;
+    float lumaEnd2 = lumaAt(uv2) - lumaLocalAverage;
+    bool reached1 = abs(lumaEnd1) >= gradientScaled;
+    bool reached2 = abs(lumaEnd2) >= gradientScaled;
+    for (int i = 1; i < SEARCH_STEPS && !(reached1 && reached2); i++) {
+        if (!reached1) {
+            uv1 -= offset * searchStep[i];
+            lumaEnd1 = lumaAt(uv1) - lumaLocalAverage;
+            reached1 = abs(lumaEnd1) >= gradientScaled;
+        }
+        if (!reached2) {
+            uv2 += offset * searchStep[i];
+            lumaEnd2 = lumaAt(uv2) - lumaLocalAverage;
+            reached2 = abs(lumaEnd2) >= gradientScaled;
+        }
+    }
+
+    // blend towards the edge by how close the pixel is to its nearer end
+    float distance1 = horizontal ? texCoord.x - uv1.x : texCoord.y - uv1.y;
+    float distance2 = horizontal ? uv2.x - texCoord.x : uv2.y - texCoord.y;
+    bool direction1 = distance1 < distance2;
+    float distanceFinal = min(distance1, distance2);
+    float edgeLength = distance1 + distance2;
+    float pixelOffset = 0.5 - distanceFinal / edgeLength;
+    bool centerSmaller = lumaCenter < lumaLocalAverage;
+    bool correctVariation = ((direction1 ? lumaEnd1 : lumaEnd2) < 0.0) != centerSmaller;
+    float finalOffset = correctVariation ? pixelOffset : 0.0;
+
+    // sub-pixel aliasing, e.g. thin features that the edge walk misses
+    float lumaAverage = (2.0 * (lumaN + lumaS + lumaW + lumaE) + lumaNW + lumaNE + lumaSW + lumaSE) / 12.0;
+    float subPixel = clamp(abs(lumaAverage - lumaCenter) / lumaRange, 0.0, 1.0);
+    subPixel = (-2.0 * subPixel + 3.0) * subPixel * subPixel;
+    finalOffset = max(finalOffset, subPixel * subPixel * SUBPIXEL_QUALITY);
+
+    vec2 finalUv = texCoord;
+    if (horizontal) {
+        finalUv.y += finalOffset * stepLength;
+    } else {
+        finalUv.x += finalOffset * stepLength;
+    }
+    FragColor = vec4(textureLod(ldrColor, finalUv, 0.0).rgb, 1.0);
+}
@@ -0,0 +1,47 @@
+#version 330 core
+// screen-aligned quad around a sphere, the fragment shader intersects the view ray with it.
+// Drawn as a 4 vertex triangle strip without vertex data
+uniform mat4 model;    // unit sphere to world, translation is the center and the scale the radius
+uniform mat4 view;
+uniform mat4 projection;
+uniform mat4 viewProj;
+uniform vec3 viewPos;
+uniform float nearPlane;
+
+out vec3 fragPos;   // a point on the view ray through the fragment
+out vec2 tileCoord; // [0, 1] across the quad, where billboard.fs samples its atlas tile
+
+const vec2 corners[4] = vec2[4](vec2(-1.0, -1.0), vec2(1.0, -1.0), vec2(-1.0, 1.0), vec2(1.0, 1.0));
+
+void main() {
+    vec3 center = model[3].xyz;
+    float radius = length(model[0].xyz);
+    vec3 toCenter = center - viewPos;
+    float distance = length(toCenter);
+
+    // the quad faces the viewer in the plane through the sphere's nearest point and is just wide
+    // enough for the cone of rays tangent to the sphere
+    vec3 forward = toCenter / distance;
+    vec3 right = normalize(cross(forward, abs(forward.y) < 0.99 ? vec3(0.0, 1.0, 0.0) : vec3(1.0, 0.0, 0.0)));
+    vec3 up = cross(right, forward);
+    float planeDistance = distance - radius;
+    float halfSize = planeDistance * radius / sqrt(max(distance * distance - radius * radius, 1e-12));
+
+    // inside or right next to the sphere the quad would cross the near plane, cover the screen instead
+    bool fullscreen = distance <= radius;
+    for (int i = 0; i < 4; i++) {
+        vec3 p = viewPos + forward * planeDistance + (right * corners[i].x + up * corners[i].y) * halfSize;
+        fullscreen = fullscreen || (viewProj * vec4(p, 1.0)).w < nearPlane * 2.0;
+    }
+
+    vec2 corner = corners[gl_VertexID];
+    tileCoord = corner * 0.5 + 0.5;
+    if (fullscreen) {
+        gl_Position = vec4(corner, 0.0, 1.0);
+        vec3 viewRay = vec3(corner.x / projection[0][0], corner.y / projection[1][1], -1.0);
+        fragPos = viewPos + transpose(mat3(view)) * viewRay;
+    } else {
+        fragPos = viewPos + forward * planeDistance + (right * corner.x + up * corner.y) * halfSize;
+        gl_Position = viewProj * vec4(fragPos, 1.0);
+    }
+}
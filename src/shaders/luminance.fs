@@ -0,0 +1,14 @@
+#version 330 core
+
+in vec2 texCoord;
+
+uniform sampler2D hdrColor;  // resolved scene radiance
+
+out vec4 FragColor;
+
+void main() {
+    vec3 color = texture(hdrColor, texCoord).rgb;
+    float luminance = dot(color, vec3(0.2126, 0.7152, 0.0722));
+    // the mip chain of this target averages log luminance down to one texel
+    FragColor = vec4(log(luminance + 1e-4), 0.0, 0.0, 1.0);
+}
@@ -1,7 +1,15 @@
 #version 330 core
 
+#ifdef IMPOSTOR
+in vec3 fragPos; // impostor.vs, a point on the view ray
+uniform mat4 model;
+uniform mat4 viewProj;
+vec3 FragPos;
+vec3 Normal;
+#else
 in vec3 FragPos;
 in vec3 Normal;
+#endif
 
 uniform vec3 viewPos;
 uniform vec3 surfaceColor;
@@ -9,7 +17,53 @@ uniform vec3 lightPos;
 
 out vec4 FragColor;
 
+#ifdef LOG_DEPTH
+uniform float logDepthCoef;
+#ifndef IMPOSTOR
+in float flogz;
+#endif
+#endif
+
+#ifdef IMPOSTOR
+// same as in copy.fs: entry and exit distance along d of a sphere around the origin,
+// (1e5, -1e5) on a miss
+vec2 raySphereIntersection(vec3 o, vec3 d, float r) {
+  float a = dot(d, d);
+  float b = 2.0 * dot(d, o);
+  float c = dot(o, o) - r * r;
+  float delta = b * b - 4.0 * a * c;
+  if (delta < 0.0)
+    return vec2(1e5, -1e5);
+  float sqrtDelta = sqrt(delta);
+  return vec2((-b - sqrtDelta) / (2.0 * a), (-b + sqrtDelta) / (2.0 * a));
+}
+
+// exact surface point, normal and depth of the sphere behind the quad's fragment
+void traceImpostor() {
+  vec3 center = model[3].xyz;
+  float radius = length(model[0].xyz);
+  vec3 ray = normalize(fragPos - viewPos);
+  vec2 t = raySphereIntersection(viewPos - center, ray, radius);
+  if (t.x > t.y || t.x < 0.0)
+    discard;
+  FragPos = viewPos + ray * t.x;
+  Normal = (FragPos - center) / radius;
+
+  vec4 clip = viewProj * vec4(FragPos, 1.0);
+#if defined(LOG_DEPTH)
+  gl_FragDepth = log2(1.0 + clip.w) * logDepthCoef * 0.5;
+#elif defined(REVERSED_Z)
+  gl_FragDepth = clip.z / clip.w;
+#else
+  gl_FragDepth = clip.z / clip.w * 0.5 + 0.5;
+#endif
+}
+#endif
+
 void main() {
+#ifdef IMPOSTOR
+  traceImpostor();
+#endif
   vec3 lightColor = vec3(1.0, 1.0, 1.0);
 
   vec3 ambient = 0.2 * lightColor;
@@ -29,4 +83,7 @@ void main() {
 
   vec3 col =  (ambient + diffuse + specular) * surfaceColor;
   FragColor = vec4(col, 1.0);
+#if defined(LOG_DEPTH) && !defined(IMPOSTOR)
+  gl_FragDepth = log2(flogz) * logDepthCoef * 0.5;
+#endif
 }
\ No newline at end of file
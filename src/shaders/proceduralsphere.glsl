@@ -0,0 +1,18 @@
+// the triangles of generateSphereMesh rebuilt from gl_VertexID, drawn without vertex data.
+// Included by the vertex shaders compiled with PROCEDURAL_SPHERE
+uniform int sphereStacks;
+uniform int sphereSlices;
+uniform float sphereRadius;
+
+// the position divided by sphereRadius is also the normal
+vec3 proceduralSpherePosition() {
+    const float PI = 3.14159265358979;
+    // corners of the quad's two triangles as (stack, slice) steps: first, second, first + 1, second, second + 1, first + 1
+    const ivec2 corners[6] = ivec2[6](ivec2(0, 0), ivec2(1, 0), ivec2(0, 1), ivec2(1, 0), ivec2(1, 1), ivec2(0, 1));
+    int quad = gl_VertexID / 6;
+    ivec2 cell = ivec2(quad / sphereSlices, quad % sphereSlices) + corners[gl_VertexID % 6];
+
+    float stackAngle = PI / 2.0 - float(cell.x) * PI / float(sphereStacks);
+    float sliceAngle = float(cell.y) * 2.0 * PI / float(sphereSlices);
+    return vec3(cos(stackAngle) * cos(sliceAngle), cos(stackAngle) * sin(sliceAngle), sin(stackAngle)) * sphereRadius;
+}
@@ -0,0 +1,9 @@
+#version 400 core
+// control points of the tessellated spheres, everything else happens in sphere.tes
+layout (location = 0) in vec3 aPos;
+
+out vec3 controlPos;
+
+void main() {
+    controlPos = aPos;
+}
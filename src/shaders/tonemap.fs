@@ -0,0 +1,19 @@
+#version 330 core
+
+in vec2 texCoord;
+
+uniform sampler2D hdrColor;          // resolved scene radiance
+uniform sampler2D adaptedLuminance;  // 1x1 temporally adapted average luminance
+uniform float exposureKey;           // middle grey the average luminance is mapped to
+uniform vec2 exposureRange;          // min and max exposure
+
+out vec4 FragColor;
+
+void main() {
+    float average = texelFetch(adaptedLuminance, ivec2(0), 0).r;
+    float exposure = clamp(exposureKey / max(average, 1e-4), exposureRange.x, exposureRange.y);
+    vec3 color = texture(hdrColor, texCoord).rgb * exposure;
+
+    // Apply tone mapping
+    FragColor = vec4(1.0 - exp(-color), 1.0);
+}
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <math.h>
+
+// Value types with static inline operations. Being visible in every translation unit lets calls
+// inline into the caller's loops and constant arguments fold at build time. mathematics.h keeps
+// the float pointer API as thin wrappers around these.
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+typedef struct
+{
+  float x, y, z;
+} vec3;
+
+typedef struct
+{
+  float x, y, z, w;
+} vec4;
+
+// column-major like OpenGL, m[column * 4 + row]
+typedef struct
+{
+  float m[16];
+} mat4;
+
+// constant initializers, usable for static data since they only need constant expressions
+#define RADIANS(degrees) ((float)((degrees) * (M_PI / 180.0)))
+#define VEC3_INIT(x, y, z) {(x), (y), (z)}
+#define MAT4_IDENTITY_INIT {{1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f}}
+#define MAT4_TRANSLATION_INIT(x, y, z) {{1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, (x), (y), (z), 1.0f}}
+#define MAT4_SCALE_INIT(x, y, z) {{(x), 0.0f, 0.0f, 0.0f, 0.0f, (y), 0.0f, 0.0f, 0.0f, 0.0f, (z), 0.0f, 0.0f, 0.0f, 0.0f, 1.0f}}
+// f is the cotangent of half the vertical field of view, tanf() is not a constant expression
+#define MAT4_PERSPECTIVE_INIT(f, aspect, near, far)                              \
+  {{(f) / (aspect), 0.0f, 0.0f, 0.0f, 0.0f, (f), 0.0f, 0.0f, 0.0f, 0.0f,         \
+    ((far) + (near)) / ((near) - (far)), -1.0f, 0.0f, 0.0f,                      \
+    2.0f * (far) * (near) / ((near) - (far)), 0.0f}}
+
+// scalars
+static inline float to_radians(float degrees)
+{
+  return degrees * (float)(M_PI / 180.0);
+}
+
+// vec3
+static inline vec3 vec3_make(float x, float y, float z)
+{
+  vec3 v = {x, y, z};
+  return v;
+}
+static inline vec3 vec3_load(const float v[3])
+{
+  return vec3_make(v[0], v[1], v[2]);
+}
+static inline void vec3_store(vec3 v, float out[3])
+{
+  out[0] = v.x;
+  out[1] = v.y;
+  out[2] = v.z;
+}
+static inline vec3 vec3_add(vec3 a, vec3 b)
+{
+  return vec3_make(a.x + b.x, a.y + b.y, a.z + b.z);
+}
+static inline vec3 vec3_sub(vec3 a, vec3 b)
+{
+  return vec3_make(a.x - b.x, a.y - b.y, a.z - b.z);
+}
+static inline vec3 vec3_scale(vec3 v, float s)
+{
+  return vec3_make(v.x * s, v.y * s, v.z * s);
+}
+static inline float vec3_dot(vec3 a, vec3 b)
+{
+  return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+static inline vec3 vec3_cross(vec3 a, vec3 b)
+{
+  return vec3_make(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+}
+static inline float vec3_length(vec3 v)
+{
+  return sqrtf(vec3_dot(v, v));
+}
+// zero length vectors are returned unchanged
+static inline vec3 vec3_normalize(vec3 v)
+{
+  float length = vec3_length(v);
+  return length > 0.0f ? vec3_scale(v, 1.0f / length) : v;
+}
+
+// vec4
+static inline vec4 vec4_make(float x, float y, float z, float w)
+{
+  vec4 v = {x, y, z, w};
+  return v;
+}
+static inline vec4 vec4_from_vec3(vec3 v, float w)
+{
+  return vec4_make(v.x, v.y, v.z, w);
+}
+static inline float vec4_dot(vec4 a, vec4 b)
+{
+  return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+}
+
+// mat4
+static inline mat4 mat4_identity(void)
+{
+  mat4 m = MAT4_IDENTITY_INIT;
+  return m;
+}
+static inline mat4 mat4_translation(float x, float y, float z)
+{
+  mat4 m = MAT4_TRANSLATION_INIT(x, y, z);
+  return m;
+}
+static inline mat4 mat4_scale(float x, float y, float z)
+{
+  mat4 m = MAT4_SCALE_INIT(x, y, z);
+  return m;
+}
+static inline mat4 mat4_perspective(float fov, float aspect, float near, float far)
+{
+  float f = 1.0f / tanf(fov / 2.0f);
+  mat4 m = MAT4_PERSPECTIVE_INIT(f, aspect, near, far);
+  return m;
+}
+static inline mat4 mat4_load(const float m[16])
+{
+  mat4 r;
+  for (int i = 0; i < 16; i++)
+    r.m[i] = m[i];
+  return r;
+}
+static inline void mat4_store(const mat4 *m, float out[16])
+{
+  for (int i = 0; i < 16; i++)
+    out[i] = m->m[i];
+}
+// a * b, b is applied first
+static inline mat4 mat4_mul(const mat4 *a, const mat4 *b)
+{
+  mat4 r;
+  for (int column = 0; column < 4; column++)
+  {
+    for (int row = 0; row < 4; row++)
+    {
+      r.m[column * 4 + row] = a->m[0 * 4 + row] * b->m[column * 4 + 0] + a->m[1 * 4 + row] * b->m[column * 4 + 1] +
+                              a->m[2 * 4 + row] * b->m[column * 4 + 2] + a->m[3 * 4 + row] * b->m[column * 4 + 3];
+    }
+  }
+  return r;
+}
+static inline vec4 mat4_mul_vec4(const mat4 *m, vec4 v)
+{
+  const float *c = m->m;
+  return vec4_make(c[0] * v.x + c[4] * v.y + c[8] * v.z + c[12] * v.w,
+                   c[1] * v.x + c[5] * v.y + c[9] * v.z + c[13] * v.w,
+                   c[2] * v.x + c[6] * v.y + c[10] * v.z + c[14] * v.w,
+                   c[3] * v.x + c[7] * v.y + c[11] * v.z + c[15] * v.w);
+}
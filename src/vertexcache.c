@@ -0,0 +1,293 @@
+#include "vertexcache.h"
+
+#include <string.h>
+
+VertexCacheStats analyzeVertexCache(const unsigned int *indices, int indexCount, int vertexCount, int cacheSize)
+{
+  VertexCacheStats stats = {0.0f, 0.0f};
+  // FIFO simulated with timestamps, a vertex is cached while fewer than cacheSize misses followed it
+  unsigned int *loadedAt = calloc(vertexCount, sizeof(unsigned int));
+  if (!loadedAt || indexCount == 0)
+  {
+    free(loadedAt);
+    return stats;
+  }
+
+  unsigned int misses = 0;
+  for (int i = 0; i < indexCount; i++)
+  {
+    unsigned int vertex = indices[i];
+    if (loadedAt[vertex] == 0 || misses - loadedAt[vertex] + 1 > (unsigned int)cacheSize)
+    {
+      misses++;
+      loadedAt[vertex] = misses;
+    }
+  }
+  free(loadedAt);
+
+  stats.acmr = (float)misses / (indexCount / 3);
+  stats.atvr = (float)misses / vertexCount;
+  return stats;
+}
+
+// Tom Forsyth, "Linear-Speed Vertex Cache Optimisation"
+#define CACHE_DECAY_POWER 1.5f
+#define LAST_TRIANGLE_SCORE 0.75f
+#define VALENCE_BOOST_SCALE 2.0f
+#define VALENCE_BOOST_POWER 0.5f
+
+static float vertexScore(int cachePosition, int remainingTriangles)
+{
+  if (remainingTriangles == 0)
+    return -1.0f;
+
+  float score = 0.0f;
+  if (cachePosition >= 0)
+  {
+    // the last triangle's vertices score the same so it is not simply continued as a strip
+    if (cachePosition < 3)
+      score = LAST_TRIANGLE_SCORE;
+    else
+      score = powf(1.0f - (float)(cachePosition - 3) / (VERTEX_CACHE_SIZE - 3), CACHE_DECAY_POWER);
+  }
+  // vertices with few triangles left are finished off before they become expensive stragglers
+  return score + VALENCE_BOOST_SCALE * powf((float)remainingTriangles, -VALENCE_BOOST_POWER);
+}
+
+int optimizeVertexCache(unsigned int *indices, int indexCount, int vertexCount)
+{
+  int triangleCount = indexCount / 3;
+  int *remaining = calloc(vertexCount, sizeof(int));  // triangles not yet emitted per vertex
+  int *adjacencyStart = malloc((vertexCount + 1) * sizeof(int));
+  int *adjacency = malloc((size_t)indexCount * sizeof(int)); // triangles of each vertex
+  int *cachePosition = malloc(vertexCount * sizeof(int));
+  float *score = malloc(vertexCount * sizeof(float));
+  float *triangleScore = malloc(triangleCount * sizeof(float));
+  char *emitted = calloc(triangleCount, 1);
+  unsigned int *output = malloc((size_t)indexCount * sizeof(unsigned int));
+  if (!remaining || !adjacencyStart || !adjacency || !cachePosition || !score || !triangleScore || !emitted || !output)
+  {
+    fprintf(stderr, "Failed to allocate vertex cache optimization of %d triangles\n", triangleCount);
+    free(remaining);
+    free(adjacencyStart);
+    free(adjacency);
+    free(cachePosition);
+    free(score);
+    free(triangleScore);
+    free(emitted);
+    free(output);
+    return 0;
+  }
+
+  // triangles of every vertex in one array
+  for (int i = 0; i < indexCount; i++)
+    remaining[indices[i]]++;
+  adjacencyStart[0] = 0;
+  for (int v = 0; v < vertexCount; v++)
+    adjacencyStart[v + 1] = adjacencyStart[v] + remaining[v];
+  int *fill = cachePosition; // reused as write cursor before the cache exists
+  memcpy(fill, adjacencyStart, vertexCount * sizeof(int));
+  for (int i = 0; i < indexCount; i++)
+    adjacency[fill[indices[i]]++] = i / 3;
+
+  for (int v = 0; v < vertexCount; v++)
+  {
+    cachePosition[v] = -1;
+    score[v] = vertexScore(-1, remaining[v]);
+  }
+  int best = -1;
+  for (int t = 0; t < triangleCount; t++)
+  {
+    triangleScore[t] = score[indices[t * 3]] + score[indices[t * 3 + 1]] + score[indices[t * 3 + 2]];
+    if (best < 0 || triangleScore[t] > triangleScore[best])
+      best = t;
+  }
+
+  int cache[VERTEX_CACHE_SIZE + 3];
+  int cacheCount = 0;
+  int nextUnemitted = 0; // fallback when nothing in the cache has triangles left
+  for (int out = 0; out < triangleCount; out++)
+  {
+    if (best < 0)
+    {
+      while (emitted[nextUnemitted])
+        nextUnemitted++;
+      best = nextUnemitted;
+    }
+
+    const unsigned int *triangle = &indices[best * 3];
+    memcpy(&output[out * 3], triangle, 3 * sizeof(unsigned int));
+    emitted[best] = 1;
+
+    // the triangle's vertices move to the front of the LRU cache
+    int newCache[VERTEX_CACHE_SIZE + 3];
+    int newCount = 0;
+    for (int k = 0; k < 3; k++)
+    {
+      unsigned int vertex = triangle[k];
+      remaining[vertex]--;
+      // drop the triangle from the vertex's list
+      int *list = &adjacency[adjacencyStart[vertex]];
+      for (int a = 0; a <= remaining[vertex]; a++)
+      {
+        if (list[a] == best)
+        {
+          list[a] = list[remaining[vertex]];
+          break;
+        }
+      }
+      newCache[newCount++] = vertex;
+    }
+    for (int c = 0; c < cacheCount; c++)
+    {
+      int vertex = cache[c];
+      if (vertex != (int)triangle[0] && vertex != (int)triangle[1] && vertex != (int)triangle[2])
+        newCache[newCount++] = vertex;
+    }
+
+    // rescore everything that was or is in the cache, the new best triangle uses one of them
+    best = -1;
+    float bestScore = -1.0f;
+    for (int c = 0; c < newCount; c++)
+    {
+      int vertex = newCache[c];
+      int position = c < VERTEX_CACHE_SIZE ? c : -1;
+      cachePosition[vertex] = position;
+      float delta = vertexScore(position, remaining[vertex]) - score[vertex];
+      score[vertex] += delta;
+      const int *list = &adjacency[adjacencyStart[vertex]];
+      for (int a = 0; a < remaining[vertex]; a++)
+      {
+        triangleScore[list[a]] += delta;
+        if (triangleScore[list[a]] > bestScore)
+        {
+          bestScore = triangleScore[list[a]];
+          best = list[a];
+        }
+      }
+    }
+    cacheCount = newCount < VERTEX_CACHE_SIZE ? newCount : VERTEX_CACHE_SIZE;
+    memcpy(cache, newCache, cacheCount * sizeof(int));
+  }
+
+  memcpy(indices, output, (size_t)indexCount * sizeof(unsigned int));
+  free(remaining);
+  free(adjacencyStart);
+  free(adjacency);
+  free(cachePosition);
+  free(score);
+  free(triangleScore);
+  free(emitted);
+  free(output);
+  return 1;
+}
+
+typedef struct
+{
+  int first, count; // triangles
+  float sortKey;
+} Cluster;
+
+static int compareClusters(const void *a, const void *b)
+{
+  float ka = ((const Cluster *)a)->sortKey, kb = ((const Cluster *)b)->sortKey;
+  return ka < kb ? 1 : (ka > kb ? -1 : 0);
+}
+
+int optimizeOverdraw(unsigned int *indices, int indexCount, const Vertex *vertices, int vertexCount)
+{
+  int triangleCount = indexCount / 3;
+  Cluster *clusters = malloc(triangleCount * sizeof(Cluster));
+  unsigned int *loadedAt = calloc(vertexCount, sizeof(unsigned int));
+  unsigned int *output = malloc((size_t)indexCount * sizeof(unsigned int));
+  if (!clusters || !loadedAt || !output)
+  {
+    fprintf(stderr, "Failed to allocate overdraw optimization of %d triangles\n", triangleCount);
+    free(clusters);
+    free(loadedAt);
+    free(output);
+    return 0;
+  }
+
+  // a triangle missing all three vertices starts from a cold cache, cutting there costs nothing
+  int clusterCount = 0;
+  unsigned int misses = 0;
+  for (int t = 0; t < triangleCount; t++)
+  {
+    int triangleMisses = 0;
+    for (int k = 0; k < 3; k++)
+    {
+      unsigned int vertex = indices[t * 3 + k];
+      if (loadedAt[vertex] == 0 || misses - loadedAt[vertex] + 1 > VERTEX_FIFO_SIZE)
+      {
+        misses++;
+        triangleMisses++;
+        loadedAt[vertex] = misses;
+      }
+    }
+    if (t == 0 || triangleMisses == 3)
+      clusters[clusterCount++] = (Cluster){t, 0, 0.0f};
+    clusters[clusterCount - 1].count++;
+  }
+
+  // area weighted centroid of the mesh, then how far each cluster faces away from it
+  vec3 meshCenter = vec3_make(0.0f, 0.0f, 0.0f);
+  float meshArea = 0.0f;
+  for (int t = 0; t < triangleCount; t++)
+  {
+    vec3 a = vec3_load(vertices[indices[t * 3]].position);
+    vec3 b = vec3_load(vertices[indices[t * 3 + 1]].position);
+    vec3 c = vec3_load(vertices[indices[t * 3 + 2]].position);
+    float area = vec3_length(vec3_cross(vec3_sub(b, a), vec3_sub(c, a)));
+    meshCenter = vec3_add(meshCenter, vec3_scale(vec3_add(a, vec3_add(b, c)), area / 3.0f));
+    meshArea += area;
+  }
+  if (meshArea > 0.0f)
+    meshCenter = vec3_scale(meshCenter, 1.0f / meshArea);
+
+  for (int i = 0; i < clusterCount; i++)
+  {
+    Cluster *cluster = &clusters[i];
+    vec3 center = vec3_make(0.0f, 0.0f, 0.0f);
+    vec3 normal = vec3_make(0.0f, 0.0f, 0.0f);
+    float area = 0.0f;
+    for (int t = cluster->first; t < cluster->first + cluster->count; t++)
+    {
+      vec3 a = vec3_load(vertices[indices[t * 3]].position);
+      vec3 b = vec3_load(vertices[indices[t * 3 + 1]].position);
+      vec3 c = vec3_load(vertices[indices[t * 3 + 2]].position);
+      vec3 faceNormal = vec3_cross(vec3_sub(b, a), vec3_sub(c, a)); // length is twice the area
+      float faceArea = vec3_length(faceNormal);
+      center = vec3_add(center, vec3_scale(vec3_add(a, vec3_add(b, c)), faceArea / 3.0f));
+      normal = vec3_add(normal, faceNormal);
+      area += faceArea;
+    }
+    if (area > 0.0f)
+      center = vec3_scale(center, 1.0f / area);
+    cluster->sortKey = vec3_dot(vec3_sub(center, meshCenter), vec3_normalize(normal));
+  }
+
+  qsort(clusters, clusterCount, sizeof(Cluster), compareClusters);
+  unsigned int *write = output;
+  for (int i = 0; i < clusterCount; i++)
+  {
+    memcpy(write, &indices[clusters[i].first * 3], clusters[i].count * 3 * sizeof(unsigned int));
+    write += clusters[i].count * 3;
+  }
+  memcpy(indices, output, (size_t)indexCount * sizeof(unsigned int));
+
+  free(clusters);
+  free(loadedAt);
+  free(output);
+  return 1;
+}
+
+int optimizeMeshIndices(const char *name, const Vertex *vertices, int vertexCount, unsigned int *indices, int indexCount)
+{
+  VertexCacheStats before = analyzeVertexCache(indices, indexCount, vertexCount, VERTEX_FIFO_SIZE);
+  if (!optimizeVertexCache(indices, indexCount, vertexCount) || !optimizeOverdraw(indices, indexCount, vertices, vertexCount))
+    return 0;
+  VertexCacheStats after = analyzeVertexCache(indices, indexCount, vertexCount, VERTEX_FIFO_SIZE);
+  printf("%s indices: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n", name, before.acmr, after.acmr, before.atvr, after.atvr);
+  return 1;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "meshes.h"
+
+#define VERTEX_CACHE_SIZE 32 // LRU entries the Forsyth scores assume
+#define VERTEX_FIFO_SIZE 16  // FIFO entries the statistics and cluster boundaries simulate
+
+typedef struct
+{
+  float acmr; // vertex shader runs per triangle, 0.5 at best for large grids, 3 without any reuse
+  float atvr; // vertex shader runs per vertex, 1 is ideal
+} VertexCacheStats;
+
+VertexCacheStats analyzeVertexCache(const unsigned int *indices, int indexCount, int vertexCount, int cacheSize);
+
+// Forsyth's linear-speed vertex cache optimization, reorders triangles in place
+int optimizeVertexCache(unsigned int *indices, int indexCount, int vertexCount);
+// splits the cache optimized order where the cache starts over and draws the clusters facing
+// away from the mesh center first, so they occlude more of what follows
+int optimizeOverdraw(unsigned int *indices, int indexCount, const Vertex *vertices, int vertexCount);
+
+// both of the above with ACMR/ATVR before and after printed under name, returns 0 when out of memory
+int optimizeMeshIndices(const char *name, const Vertex *vertices, int vertexCount, unsigned int *indices, int indexCount);